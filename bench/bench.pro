@@ -0,0 +1,18 @@
+include(../common.pri)
+include(../core/core.pri)
+
+TARGET = NewtonFractalBench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DESTDIR = ../build
+
+SOURCES += \
+    main.cpp \
+    benchmark.cpp \
+    scenes.cpp
+
+HEADERS += \
+    benchmark.h \
+    scenes.h
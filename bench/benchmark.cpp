@@ -0,0 +1,554 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "benchmark.h"
+#include "newton.h"
+#include "renderer.h"
+#include "kernelcache.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+
+static constexpr int FUNC_CALLS = 1 << 22;		// Calls per func sample
+static constexpr int FUNC_POINTS = 1 << 12;		// Distinct points for func
+static constexpr double FLOAT_TOLERANCE = 99.9;	// Min. % of pixels float must match double
+static constexpr int DEGREE_POINTS = 64 * 64;	// Start points per degree
+
+static double median(QVector<double> values)
+{
+	// Median of values, 0 if empty
+	if (values.isEmpty()) return 0;
+	std::sort(values.begin(), values.end());
+	int n = values.size();
+	return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+QJsonObject Result::toJson() const
+{
+	// Summarize samples
+	QVector<double> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0;
+	for (double s : sorted) sum += s;
+	int n = sorted.size();
+
+	QJsonObject obj = info;
+	obj["name"] = name;
+	obj["scene"] = scene;
+	obj["unit"] = unit;
+	obj["repetitions"] = n;
+	if (n > 0) {
+		obj["median"] = median(sorted);
+		obj["min"] = sorted.first();
+		obj["max"] = sorted.last();
+		obj["mean"] = sum / n;
+	}
+	return obj;
+}
+
+Benchmark::Benchmark(int repetitions) :
+	repetitions_(qMax(1, repetitions))
+{
+}
+
+Result Benchmark::measureFunc(const Scene &scene)
+{
+	// Spread points over the visible area
+	const Parameters &params = scene.params;
+	QVector<complex> points(FUNC_POINTS);
+	for (int i = 0; i < FUNC_POINTS; ++i) {
+		double x = (i % 64) / 63.0;
+		double y = (i / 64) / 63.0;
+		points[i] = complex(
+			params.limits.left() + x * params.limits.width(),
+			params.limits.bottom() + y * params.limits.height());
+	}
+
+	// Time plain func calls, sink results so nothing gets optimized away.
+	// Above nf::SRC roots the kernels never call func, time the table instead.
+	Result result = {"func", scene.name, "ns/iteration", {}, {}};
+	result.info["roots"] = params.roots.count();
+	const bool many = params.roots.count() > nf::SRC;
+	result.info["evaluator"] = many ? "RootTable::quotient" : "func";
+	const RootTable table(many ? params.roots : QVector<Root>());
+	volatile double sink = 0;
+	for (int r = 0; r < repetitions_; ++r) {
+		complex acc(0, 0);
+		QElapsedTimer timer;
+		timer.start();
+		if (many) {
+			for (int i = 0; i < FUNC_CALLS; i += nf::FLN) {
+				double x[nf::FLN], y[nf::FLN], qr[nf::FLN], qi[nf::FLN];
+				for (int l = 0; l < nf::FLN; ++l) {
+					const complex &z = points[(i + l) & (FUNC_POINTS - 1)];
+					x[l] = z.real();
+					y[l] = z.imag();
+				}
+				table.quotient(x, y, qr, qi);
+				for (int l = 0; l < nf::FLN; ++l) acc += complex(qr[l], qi[l]);
+			}
+		} else {
+			for (int i = 0; i < FUNC_CALLS; ++i) {
+				complex f, df;
+				func(points[i & (FUNC_POINTS - 1)], f, df, params.roots);
+				acc += f + df;
+			}
+		}
+		qint64 ns = timer.nsecsElapsed();
+		sink = sink + acc.real();
+		result.samples.append(double(ns) / FUNC_CALLS);
+	}
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureIterateX(const Scene &scene, QSize size)
+{
+	// Render whole frame line by line on this thread
+	Parameters params = scene.params;
+	params.size = size;
+	QVector<QRgb> buffer(size.width());
+	Result result = {"iterateX", scene.name, "pixels/s", {}, {}};
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	for (int r = 0; r < repetitions_; ++r) {
+		QElapsedTimer timer;
+		timer.start();
+		for (int y = 0; y < size.height(); ++y) {
+			renderTile(params, size, QRect(0, y, size.width(), 1), buffer.data(), size.width());
+		}
+		qint64 ns = timer.nsecsElapsed();
+		result.samples.append(1e9 * size.width() * size.height() / qMax<qint64>(ns, 1));
+	}
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureFloatAgreement(const Scene &scene, QSize size)
+{
+	// Render the frame once with and once without the float kernel
+	Parameters params = scene.params;
+	params.size = size;
+	QVector<QRgb> image[2];
+	double ms[2];
+	for (int f = 0; f < 2; ++f) {
+		params.floatPrecision = f == 0;
+		image[f].resize(size.width() * size.height());
+		QElapsedTimer timer;
+		timer.start();
+		renderTile(params, size, QRect(QPoint(0, 0), size), image[f].data(), size.width());
+		ms[f] = timer.nsecsElapsed() / 1e6;
+	}
+
+	// Same color means same root and same iteration count
+	int same = 0;
+	for (int i = 0; i < image[0].size(); ++i) {
+		same += image[0][i] == image[1][i];
+	}
+	params.floatPrecision = true;
+	Result result = {"floatAgreement", scene.name, "% pixels", {100.0 * same / qMax(1, image[0].size())}, {}};
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	result.info["precision"] = precision2string(params.precision());
+	result.info["tolerance"] = FLOAT_TOLERANCE;
+	result.info["withinTolerance"] = result.samples.first() >= FLOAT_TOLERANCE;
+	result.info["floatMs"] = ms[0];
+	result.info["doubleMs"] = ms[1];
+	result.info["speedup"] = ms[1] / qMax(1e-9, ms[0]);
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureRenderFractal(const Scene &scene, QSize size, uint threads)
+{
+	// Benchmark mode renders exactly params.size
+	Parameters params = scene.params;
+	params.size = size;
+	params.benchmark = true;
+	params.scaleUpFactor = 1;
+	params.processor = threads == 1 ? CPU_SINGLE : CPU_MULTI;
+
+	Result result = {"renderFractal", scene.name, "ms", {}, {}};
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	result.info["threads"] = int(threads);
+	result.info["precision"] = precision2string(params.precision());
+	Symmetry symmetry(params, size);
+	result.info["symmetry"] = symmetry.order();
+	result.info["mirror"] = symmetry.mirror();
+	int filled = 0;
+	for (int y = 0; y < size.height(); ++y) {
+		for (int x = 0; x < size.width(); ++x) {
+			int turns;
+			bool mirrored;
+			filled += symmetry.source(x, y, turns, mirrored) >= 0;
+		}
+	}
+	result.info["filledShare"] = double(filled) / (size.width() * size.height());
+	for (int r = 0; r < repetitions_; ++r) {
+
+		// Fresh renderer, otherwise unchanged params won't render again
+		Renderer renderer;
+		renderer.setThreadCount(threads);
+		QEventLoop loop;
+		QObject::connect(&renderer, &Renderer::benchmarkFinished, &loop, &QEventLoop::quit);
+
+		// Measure from request to finished frame
+		QElapsedTimer timer;
+		timer.start();
+		renderer.render(params);
+		loop.exec();
+		result.samples.append(timer.nsecsElapsed() / 1e6);
+	}
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureCounters(const Scene &scene, QSize size, uint threads)
+{
+	// Hardware counters per frame, samples are newton iterations per cycle
+	Result result = {"perfCounters", scene.name, "iterations/cycle", {}, {}};
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	result.info["threads"] = int(threads);
+	QVector<double> values[PerfCounterCount];
+	QVector<double> ipc, instructionsPerIteration;
+	for (int r = 0; r < repetitions_; ++r) {
+		FrameStats stats = renderFrame(scene.params, size, threads);
+		const PerfCounts &counts = stats.counters;
+		if (!counts.isValid()) continue;
+		for (int c = 0; c < PerfCounterCount; ++c) {
+			if (counts.available[c]) values[c].append(counts.value[c]);
+		}
+		ipc.append(counts.ipc());
+
+		// Iterations are only counted with statistics compiled in
+		const quint64 iterations = stats.iterations();
+		if (iterations == 0) continue;
+		result.samples.append(counts.perCycle(iterations));
+		instructionsPerIteration.append(double(counts.value[PerfInstructions]) / iterations);
+	}
+
+	// Medians of the frame totals and derived metrics
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		if (!values[c].isEmpty()) result.info[PerfCounters::name(PerfCounter(c))] = median(values[c]);
+	}
+	result.info["ipc"] = median(ipc);
+	result.info["instructionsPerIteration"] = median(instructionsPerIteration);
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureAntiAliasing(const Scene &scene, QSize size, SamplePattern pattern)
+{
+	// Edge supersampling against rendering every sample, at the same samples per pixel
+	const int samples = samplePattern(pattern).size();
+	const int factor = qMax(1, qRound(qSqrt(samples)));
+	const uint threads = QThread::idealThreadCount();
+	Parameters params = scene.params;
+	QVector<double> plain, antialiased, bruteForce;
+	for (int r = 0; r < repetitions_; ++r) {
+		params.antiAliasing = SAMPLES_NONE;
+		plain.append(renderFrame(params, size, threads).duration() / 1e6);
+		bruteForce.append(renderFrame(params, size * factor, threads).duration() / 1e6);
+		params.antiAliasing = pattern;
+		antialiased.append(renderFrame(params, size, threads).duration() / 1e6);
+	}
+
+	// Samples are the cost relative to brute force
+	Result result = {"antiAliasing", scene.name, "% of brute force", {}, {}};
+	for (int r = 0; r < repetitions_; ++r) {
+		result.samples.append(100.0 * antialiased[r] / qMax(1e-9, bruteForce[r]));
+	}
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	result.info["pattern"] = samples2string(pattern);
+	result.info["plainMs"] = median(plain);
+	result.info["antiAliasedMs"] = median(antialiased);
+	result.info["bruteForceMs"] = median(bruteForce);
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureDensityMap(const Scene &scene, QSize size, uint threads)
+{
+	// Density map on one thread against the given thread count
+	Parameters params = scene.params;
+	params.size = size;
+	params.benchmark = true;
+	params.scaleUpFactor = 1;
+	params.densityMap = true;
+	QVector<double> single, multi;
+	for (int r = 0; r < repetitions_; ++r) {
+		for (uint t : {1u, threads}) {
+
+			// Fresh renderer, otherwise unchanged params won't render again
+			params.processor = t == 1 ? CPU_SINGLE : CPU_MULTI;
+			Renderer renderer;
+			renderer.setThreadCount(t);
+			QEventLoop loop;
+			QObject::connect(&renderer, &Renderer::benchmarkFinished, &loop, &QEventLoop::quit);
+			QElapsedTimer timer;
+			timer.start();
+			renderer.render(params);
+			loop.exec();
+			(t == 1 ? single : multi).append(timer.nsecsElapsed() / 1e6);
+		}
+	}
+
+	// Samples are the frame times at the given thread count
+	Result result = {"densityMap", scene.name, "ms", multi, {}};
+	const double speedup = median(single) / qMax(1e-9, median(multi));
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	result.info["threads"] = int(threads);
+	result.info["singleMs"] = median(single);
+	result.info["speedup"] = speedup;
+	result.info["efficiency"] = speedup / threads;
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureExpression(const Scene &scene, QSize size, uint threads)
+{
+	// Same polynomial as f(z) string, both in double precision
+	Parameters params = scene.params;
+	params.floatPrecision = false;
+	params.perturbation = false;
+	params.symmetry = false;
+	QStringList factors;
+	for (const Root &root : params.roots) {
+		const complex z = root.value();
+		factors.append(QString("(z-(%1%2%3i))").arg(z.real(), 0, 'g', 17)
+			.arg(z.imag() < 0 ? '-' : '+').arg(qAbs(z.imag()), 0, 'g', 17));
+	}
+	Parameters custom = params;
+	custom.function = factors.join("");
+	custom.nativeFunction = false;
+
+	// Compile before timing, frames would otherwise include the compiler
+	Parameters native = custom;
+	native.nativeFunction = true;
+	KernelCache &cache = KernelCache::instance();
+	const bool compiled = cache.compile(Expression::compile(native.function)) != nullptr;
+	QVector<double> roots, bytecode, machine;
+	for (int r = 0; r < repetitions_; ++r) {
+		roots.append(renderFrame(params, size, threads).duration() / 1e6);
+		bytecode.append(renderFrame(custom, size, threads).duration() / 1e6);
+		if (compiled) machine.append(renderFrame(native, size, threads).duration() / 1e6);
+	}
+
+	// Samples are the frame times of the interpreted function
+	Result result = {"expression", scene.name, "ms", bytecode, {}};
+	result.info["width"] = size.width();
+	result.info["height"] = size.height();
+	result.info["threads"] = int(threads);
+	result.info["function"] = custom.function;
+	result.info["rootsMs"] = median(roots);
+	result.info["ratio"] = median(bytecode) / qMax(1e-9, median(roots));
+	result.info["native"] = compiled;
+	if (compiled) {
+		result.info["compiler"] = cache.compiler();
+		result.info["nativeMs"] = median(machine);
+		result.info["nativeRatio"] = median(machine) / qMax(1e-9, median(roots));
+	} else result.info["nativeError"] = cache.error();
+	add(result);
+	return result;
+}
+
+Result Benchmark::measureDegree(int degree)
+{
+	// Roots of unity, start points on a grid over the default view
+	Parameters params = defaultParameters(degree);
+	const RootTable table(params.roots);
+	QVector<double> xs(DEGREE_POINTS), ys(DEGREE_POINTS);
+	for (int i = 0; i < DEGREE_POINTS; ++i) {
+		xs[i] = params.limits.left() + (i % 64) / 63.0 * params.limits.width();
+		ys[i] = params.limits.bottom() + (i / 64) / 63.0 * params.limits.height();
+	}
+
+	// Lanes over the root table against the scalar kernel, per iteration
+	QVector<double> lanes, scalar;
+	quint64 iterations = 0;
+	for (int r = 0; r < repetitions_; ++r) {
+		QElapsedTimer timer;
+		timer.start();
+		iterations = 0;
+		for (int k = 0; k < DEGREE_POINTS; k += nf::FLN) {
+			int roots[nf::FLN];
+			quint16 counts[nf::FLN];
+			quint8 fractions[nf::FLN];
+			complex last[nf::FLN];
+			iterateZR(xs.constData() + k, ys.constData() + k, nf::FLN, params, table, roots, counts, fractions, last);
+			for (int l = 0; l < nf::FLN; ++l) iterations += roots[l] >= 0 ? counts[l] + 1 : counts[l];
+		}
+		lanes.append(double(timer.nsecsElapsed()) / qMax<quint64>(1, iterations));
+
+		timer.start();
+		quint64 scalarIterations = 0;
+		for (int k = 0; k < DEGREE_POINTS; ++k) {
+			quint16 i;
+			int root = iterateZ(complex(xs[k], ys[k]), params, i, 0, nullptr, nullptr, &table);
+			scalarIterations += root >= 0 ? i + 1 : i;
+		}
+		scalar.append(double(timer.nsecsElapsed()) / qMax<quint64>(1, scalarIterations));
+	}
+
+	// Samples are ns per iteration of the lanes, cost per root shows the scaling
+	Result result = {"degree", QString("unity%1").arg(degree), "ns/iteration", lanes, {}};
+	result.info["roots"] = degree;
+	result.info["points"] = DEGREE_POINTS;
+	result.info["iterations"] = double(iterations);
+	result.info["nsPerRoot"] = median(lanes) / degree;
+	result.info["scalarNs"] = median(scalar);
+	result.info["scalarNsPerRoot"] = median(scalar) / degree;
+	add(result);
+	return result;
+}
+
+QVector<Scaling> Benchmark::measureScaling(const Scene &scene, QSize size, uint maxThreads)
+{
+	// Same view at the requested size
+	Parameters params = scene.params;
+	params.size = size;
+
+	// Sweep thread counts, median over repetitions
+	QVector<Scaling> sweep;
+	double single = 0;
+	for (uint threads = 1; threads <= maxThreads; ++threads) {
+		QVector<Scaling> runs;
+		QVector<double> ms;
+		for (int r = 0; r < repetitions_; ++r) {
+			runs.append(runScaling(params, size, threads));
+			ms.append(runs.last().ms);
+		}
+
+		// Pick the median run and derive speedup and efficiency
+		double m = median(ms);
+		Scaling best = runs.first();
+		for (const Scaling &run : runs) {
+			if (qAbs(run.ms - m) < qAbs(best.ms - m)) best = run;
+		}
+		if (threads == 1) single = best.ms;
+		best.scene = scene.name;
+		best.speedup = single / best.ms;
+		best.efficiency = best.speedup / threads;
+		sweep.append(best);
+
+		// Also keep it as regular result
+		Result result = {"threadScaling", scene.name, "ms", ms, {}};
+		result.info["width"] = size.width();
+		result.info["height"] = size.height();
+		result.info["threads"] = int(threads);
+		result.info["speedup"] = best.speedup;
+		result.info["efficiency"] = best.efficiency;
+		result.info["tailIdleMs"] = best.tailIdleMs;
+		result.info["tailIdleFraction"] = best.tailIdleFraction;
+		add(result);
+	}
+	scaling_ += sweep;
+	return sweep;
+}
+
+Scaling Benchmark::runScaling(const Parameters &params, QSize size, uint threads)
+{
+	// Render with line statistics
+	FrameStats stats = renderFrame(params, size, threads);
+	qint64 frame = qMax<qint64>(1, stats.duration());
+
+	// Tail idle is the time between a worker's last line and the frame end,
+	// workers that got no line at all are idle for the whole frame
+	QVector<ThreadStats> workers = stats.threads();
+	qint64 idle = qint64(threads - qMin<uint>(threads, workers.size())) * frame;
+	for (const ThreadStats &ts : workers) {
+		idle += frame - ts.lastEnd;
+	}
+
+	Scaling scaling;
+	scaling.size = size;
+	scaling.threads = threads;
+	scaling.ms = frame / 1e6;
+	scaling.speedup = 1;
+	scaling.efficiency = 1;
+	scaling.tailIdleMs = idle / 1e6 / threads;
+	scaling.tailIdleFraction = double(idle) / (double(frame) * threads);
+	return scaling;
+}
+
+FrameStats Benchmark::renderFrame(const Parameters &params, QSize size, uint threads)
+{
+	// Benchmark mode renders exactly params.size
+	Parameters p = params;
+	p.size = size;
+	p.benchmark = true;
+	p.scaleUpFactor = 1;
+	p.processor = threads == 1 ? CPU_SINGLE : CPU_MULTI;
+
+	// Fresh renderer, otherwise unchanged params won't render again
+	Renderer renderer;
+	renderer.setThreadCount(threads);
+	renderer.setStatsEnabled(true);
+	renderer.setCountersEnabled(true);
+	QEventLoop loop;
+	QObject::connect(&renderer, &Renderer::benchmarkFinished, &loop, &QEventLoop::quit);
+	renderer.render(p);
+	loop.exec();
+	return renderer.frameStats();
+}
+
+QJsonObject Benchmark::toJson() const
+{
+	// System information
+	QJsonObject system;
+	system["os"] = QSysInfo::prettyProductName();
+	system["arch"] = QSysInfo::currentCpuArchitecture();
+	system["abi"] = QSysInfo::buildAbi();
+	system["idealThreadCount"] = QThread::idealThreadCount();
+	PerfCounters &counters = PerfCounters::instance();
+	system["perfCounters"] = counters.isAvailable() ? QString("available") : counters.error();
+
+	// Results
+	QJsonArray results;
+	for (const Result &result : results_) {
+		results.append(result.toJson());
+	}
+
+	QJsonObject obj;
+	obj["application"] = QCoreApplication::applicationName();
+	obj["version"] = QCoreApplication::applicationVersion();
+	obj["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+	obj["system"] = system;
+	obj["results"] = results;
+	return obj;
+}
+
+bool Benchmark::writeScalingCsv(const QString &fileName) const
+{
+	// One line per scene, size and thread count
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+	QTextStream out(&file);
+	out << "scene,width,height,threads,ms,speedup,efficiency,tailIdleMs,tailIdleFraction\n";
+	for (const Scaling &s : scaling_) {
+		out << s.scene << "," << s.size.width() << "," << s.size.height() << "," << s.threads << ","
+			<< s.ms << "," << s.speedup << "," << s.efficiency << ","
+			<< s.tailIdleMs << "," << s.tailIdleFraction << "\n";
+	}
+	return true;
+}
+
+void Benchmark::add(const Result &result)
+{
+	// Append result
+	results_.append(result);
+}
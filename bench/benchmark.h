@@ -0,0 +1,63 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "scenes.h"
+#include "renderstats.h"
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QVector>
+
+struct Result {
+	QString name;
+	QString scene;
+	QString unit;
+	QVector<double> samples;
+	QJsonObject info;
+	QJsonObject toJson() const;
+};
+
+struct Scaling {
+	QString scene;
+	QSize size;
+	uint threads;
+	double ms;
+	double speedup;
+	double efficiency;
+	double tailIdleMs;
+	double tailIdleFraction;
+};
+
+class Benchmark
+{
+public:
+	Benchmark(int repetitions);
+	Result measureFunc(const Scene &scene);
+	Result measureIterateX(const Scene &scene, QSize size);
+	Result measureRenderFractal(const Scene &scene, QSize size, uint threads);
+	Result measureFloatAgreement(const Scene &scene, QSize size);
+	Result measureCounters(const Scene &scene, QSize size, uint threads);
+	Result measureAntiAliasing(const Scene &scene, QSize size, SamplePattern pattern);
+	Result measureDensityMap(const Scene &scene, QSize size, uint threads);
+	Result measureExpression(const Scene &scene, QSize size, uint threads);
+	Result measureDegree(int degree);
+	QVector<Scaling> measureScaling(const Scene &scene, QSize size, uint maxThreads);
+	QJsonObject toJson() const;
+	bool writeScalingCsv(const QString &fileName) const;
+
+protected:
+	void add(const Result &result);
+	Scaling runScaling(const Parameters &params, QSize size, uint threads);
+	FrameStats renderFrame(const Parameters &params, QSize size, uint threads);
+
+private:
+	int repetitions_;
+	QVector<Result> results_;
+	QVector<Scaling> scaling_;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,179 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "benchmark.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QThread>
+#include <QFile>
+
+static QVector<int> intList(const QString &text)
+{
+	// Convert comma separated list to ints, skip invalid entries
+	QVector<int> list;
+	for (const QString &part : text.split(',', QString::SkipEmptyParts)) {
+		bool ok;
+		int value = part.trimmed().toInt(&ok);
+		if (ok && value > 0) list.append(value);
+	}
+	return list;
+}
+
+int main(int argc, char *argv[])
+{
+	// Initialize application
+	QCoreApplication app(argc, argv);
+	app.setApplicationName("NewtonFractalBench");
+	app.setApplicationVersion(APP_VERSION);
+	QTextStream err(stderr);
+
+	// Command line options
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Benchmarks func, iterateX and renderFractal on fixed scenes");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addOption({{"o", "output"}, "Write JSON results to <file> instead of stdout.", "file"});
+	parser.addOption({{"r", "repetitions"}, "Samples per measurement.", "n", "5"});
+	parser.addOption({"sizes", "Comma separated frame sizes for renderFractal.", "list", "256,512,1024"});
+	parser.addOption({"threads", "Comma separated thread counts for renderFractal.", "list",
+		QString("1,%1").arg(QThread::idealThreadCount())});
+	parser.addOption({"scenes", "Comma separated scene names, default is all.", "list"});
+	parser.addOption({"degrees", "Comma separated root counts for the cost per iteration.", "list",
+		"5,10,20,50,100,200,500"});
+	parser.addOption({"sweep", "Sweep thread counts from 1 to --sweep-max and report scaling."});
+	parser.addOption({"sweep-max", "Maximum thread count of the sweep.", "n",
+		QString::number(QThread::idealThreadCount())});
+	parser.addOption({"sweep-size", "Frame size of the sweep.", "size", QString::number(nf::DSI)});
+	parser.addOption({"csv", "Also write the sweep as CSV to <file> for plotting.", "file"});
+	parser.addOption({"no-counters", "Do not read hardware performance counters."});
+	parser.addOption({"list", "List available scenes and exit."});
+	parser.process(app);
+
+	// List scenes
+	QVector<Scene> scenes = standardScenes();
+	if (parser.isSet("list")) {
+		QTextStream out(stdout);
+		for (const Scene &scene : scenes) {
+			out << scene.name << "\t" << scene.description << "\n";
+		}
+		return 0;
+	}
+
+	// Filter scenes
+	if (parser.isSet("scenes")) {
+		QStringList names = parser.value("scenes").split(',', QString::SkipEmptyParts);
+		QVector<Scene> selected;
+		for (const Scene &scene : scenes) {
+			if (names.contains(scene.name)) selected.append(scene);
+		}
+		scenes = selected;
+	}
+
+	// Run benchmarks
+	Benchmark bench(parser.value("repetitions").toInt());
+	QVector<int> sizes = intList(parser.value("sizes"));
+	QVector<int> threads = intList(parser.value("threads"));
+	PerfCounters &counters = PerfCounters::instance();
+	bool countersEnabled = !parser.isSet("no-counters") && counters.isAvailable();
+	if (!parser.isSet("no-counters") && !countersEnabled) {
+		err << "Hardware counters unavailable: " << counters.error() << "\n";
+	}
+	for (const Scene &scene : scenes) {
+		err << "Scene " << scene.name << ": " << scene.description << "\n";
+		err.flush();
+		bench.measureFunc(scene);
+		bench.measureIterateX(scene, QSize(nf::DSI, nf::DSI));
+		Result agreement = bench.measureFloatAgreement(scene, QSize(nf::DSI, nf::DSI));
+		err << QString("  %1: %2% of pixels match double, %3x faster\n")
+			.arg(agreement.info["precision"].toString())
+			.arg(agreement.samples.first(), 0, 'f', 3)
+			.arg(agreement.info["speedup"].toDouble(), 0, 'f', 2);
+		if (!agreement.info["withinTolerance"].toBool()) {
+			err << "  Float results are out of tolerance\n";
+		}
+		for (int size : sizes) {
+			for (int t : threads) {
+				bench.measureRenderFractal(scene, QSize(size, size), t);
+			}
+		}
+		Result aa = bench.measureAntiAliasing(scene, QSize(nf::DSI, nf::DSI), SAMPLES_ROTATED4);
+		err << QString("  anti-aliasing: %1 ms instead of %2 ms, %3% of brute force\n")
+			.arg(aa.info["antiAliasedMs"].toDouble(), 0, 'f', 2)
+			.arg(aa.info["bruteForceMs"].toDouble(), 0, 'f', 2)
+			.arg(aa.toJson()["median"].toDouble(), 0, 'f', 1);
+		Result density = bench.measureDensityMap(scene, QSize(nf::DSI, nf::DSI), QThread::idealThreadCount());
+		err << QString("  density map: %1 ms on %2 threads, speedup %3\n")
+			.arg(density.toJson()["median"].toDouble(), 0, 'f', 2)
+			.arg(density.info["threads"].toInt())
+			.arg(density.info["speedup"].toDouble(), 0, 'f', 2);
+		Result expression = bench.measureExpression(scene, QSize(nf::DSI, nf::DSI), QThread::idealThreadCount());
+		err << QString("  custom f(z): %1 ms instead of %2 ms, %3x the roots\n")
+			.arg(expression.toJson()["median"].toDouble(), 0, 'f', 2)
+			.arg(expression.info["rootsMs"].toDouble(), 0, 'f', 2)
+			.arg(expression.info["ratio"].toDouble(), 0, 'f', 2);
+		if (expression.info["native"].toBool()) {
+			err << QString("  native f(z): %1 ms, %2x the roots\n")
+				.arg(expression.info["nativeMs"].toDouble(), 0, 'f', 2)
+				.arg(expression.info["nativeRatio"].toDouble(), 0, 'f', 2);
+		} else err << "  native f(z) unavailable: " << expression.info["nativeError"].toString() << "\n";
+
+		// Hardware counters of one frame per thread count
+		if (countersEnabled) {
+			int size = sizes.isEmpty() ? int(nf::DSI) : sizes.last();
+			for (int t : threads) {
+				Result r = bench.measureCounters(scene, QSize(size, size), t);
+				err << QString("  %1 threads: IPC %2, %3 iterations/cycle\n")
+					.arg(t).arg(r.info["ipc"].toDouble(), 0, 'f', 2)
+					.arg(r.toJson()["median"].toDouble(), 0, 'f', 4);
+			}
+			err.flush();
+		}
+
+		// Thread scaling sweep
+		if (parser.isSet("sweep")) {
+			int size = qMax(int(nf::MSI), parser.value("sweep-size").toInt());
+			uint maxThreads = qMax(1, parser.value("sweep-max").toInt());
+			for (const Scaling &s : bench.measureScaling(scene, QSize(size, size), maxThreads)) {
+				err << QString("  %1 threads: %2 ms, speedup %3, efficiency %4, tail idle %5 ms\n")
+					.arg(s.threads).arg(s.ms, 0, 'f', 2).arg(s.speedup, 0, 'f', 2)
+					.arg(s.efficiency, 0, 'f', 2).arg(s.tailIdleMs, 0, 'f', 2);
+			}
+			err.flush();
+		}
+	}
+
+	// Cost per iteration against the degree, roots of unity
+	for (int degree : intList(parser.value("degrees"))) {
+		Result r = bench.measureDegree(qMin<int>(degree, nf::MRC));
+		err << QString("Degree %1: %2 ns/iteration, %3 ns per root, scalar %4 ns/iteration\n")
+			.arg(r.info["roots"].toInt())
+			.arg(r.toJson()["median"].toDouble(), 0, 'f', 2)
+			.arg(r.info["nsPerRoot"].toDouble(), 0, 'f', 3)
+			.arg(r.info["scalarNs"].toDouble(), 0, 'f', 2);
+		err.flush();
+	}
+
+	// Write sweep for plotting
+	if (parser.isSet("csv") && !bench.writeScalingCsv(parser.value("csv"))) {
+		err << "Cannot write " << parser.value("csv") << "\n";
+		return 1;
+	}
+
+	// Write results
+	QByteArray json = QJsonDocument(bench.toJson()).toJson();
+	if (parser.isSet("output")) {
+		QFile file(parser.value("output"));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			err << "Cannot write " << file.fileName() << "\n";
+			return 1;
+		}
+		file.write(json);
+	} else {
+		QTextStream(stdout) << json;
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "scenes.h"
+#include "newton.h"
+#include <random>
+
+Parameters defaultParameters(int rootCount)
+{
+	// Equidistant roots on the unit circle, default view
+	Parameters params;
+	for (int i = 0; i < rootCount; ++i) {
+		params.roots.append(Root(complex(0, 0), nf::predefColors[i % nf::PCC]));
+	}
+	params.reset();
+	params.processor = CPU_MULTI;
+	return params;
+}
+
+QVector<Scene> standardScenes()
+{
+	// Fixed scenes, do not change them or results won't be comparable
+	QVector<Scene> scenes;
+	scenes.append({"roots3", "3 roots, default view", defaultParameters(3)});
+	scenes.append({"roots5", "5 roots, default view", defaultParameters(5)});
+	scenes.append({"roots10", "10 roots, default view", defaultParameters(10)});
+
+	// Deep zoom onto the boundary between the first two basins
+	Scene deep = {"deepzoom", "5 roots, zoom 1e9 on a basin boundary", defaultParameters(5)};
+	centerOn(deep.params, boundaryPoint(deep.params, 0, 1), 1e9);
+	scenes.append(deep);
+
+	// Beyond double resolution, renders with perturbation
+	Scene ultra = {"ultradeep", "5 roots, zoom 1e15 on a basin boundary", defaultParameters(5)};
+	centerOn(ultra.params, boundaryPoint(ultra.params, 0, 1), 1e15);
+	scenes.append(ultra);
+
+	// Same view with the brute force double-double kernel for comparison
+	Scene ultraDD = {"ultradeepdd", "5 roots, zoom 1e15, double-double instead of perturbation", ultra.params};
+	ultraDD.params.perturbation = false;
+	scenes.append(ultraDD);
+
+	// Heavy damping needs a lot more iterations per pixel
+	Scene damped = {"damping", "5 roots, damping 0.25", defaultParameters(5)};
+	damped.params.damping = complex(0.25, 0);
+	scenes.append(damped);
+
+	// The origin is a critical point, every basin meets in its neighbourhood
+	Scene boundary = {"boundary", "5 roots, zoom 16 on the origin", defaultParameters(5)};
+	centerOn(boundary.params, complex(0, 0), 16);
+	scenes.append(boundary);
+
+	// High degrees go through the root table
+	scenes.append({"unity100", "100 roots of unity, default view", defaultParameters(100)});
+
+	// Random roots in the unit disc from a fixed seed, the raw generator
+	// output is the same with every standard library
+	Scene random = {"random250", "250 random roots in the unit disc, default view", defaultParameters(250)};
+	std::mt19937 generator(250);
+	for (Root &root : random.params.roots) {
+		const double radius = std::sqrt(generator() / 4294967296.0);
+		const double angle = 2 * nf::PI * (generator() / 4294967296.0);
+		root.setValue(std::polar(radius, angle));
+	}
+	scenes.append(random);
+	return scenes;
+}
+
+complex boundaryPoint(const Parameters &params, int first, int second)
+{
+	// Bisect the line between two roots until the basin changes
+	complex a = params.roots[first].value();
+	complex b = params.roots[second].value();
+	quint16 iteration;
+	int ra = iterateZ(a, params, iteration);
+	for (int i = 0; i < 64; ++i) {
+		complex m = 0.5 * (a + b);
+		if (iterateZ(m, params, iteration) == ra) a = m;
+		else b = m;
+	}
+	return 0.5 * (a + b);
+}
+
+void centerOn(Parameters &params, complex center, double zoomFactor)
+{
+	// Center limits on point and zoom relative to original limits
+	const double w2 = 0.5 * params.limits.original().width() / zoomFactor;
+	const double h2 = 0.5 * params.limits.original().height() / zoomFactor;
+	const ddouble x(center.real()), y(center.imag());
+	params.limits.set(x - ddouble(w2), x + ddouble(w2), y + ddouble(h2), y - ddouble(h2));
+}
@@ -0,0 +1,24 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef SCENES_H
+#define SCENES_H
+
+#include "parameters.h"
+#include <QString>
+#include <QVector>
+
+struct Scene {
+	QString name;
+	QString description;
+	Parameters params;
+};
+
+QVector<Scene> standardScenes();
+Parameters defaultParameters(int rootCount);
+complex boundaryPoint(const Parameters &params, int first, int second);
+void centerOn(Parameters &params, complex center, double zoomFactor);
+
+#endif // SCENES_H
@@ -0,0 +1,21 @@
+CONFIG += c++14 debug_and_release
+VERSION = 1.6.2
+DEFINES += APP_VERSION=\\\"$$VERSION\\\"
+
+# Compile out per line render statistics and trace spans
+nostats: DEFINES += NF_NO_STATS
+notrace: DEFINES += NF_NO_TRACE
+
+CONFIG(release, debug|release) {
+    OBJECTS_DIR = release/obj
+    MOC_DIR = release/moc
+    RCC_DIR = release/rcc
+    UI_DIR = release/ui
+}
+
+CONFIG(debug, debug|release) {
+    OBJECTS_DIR = debug/obj
+    MOC_DIR = debug/moc
+    RCC_DIR = debug/rcc
+    UI_DIR = debug/ui
+}
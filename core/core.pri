@@ -0,0 +1,11 @@
+# Link against the compute core, include this in any project using it
+QT += core gui concurrent
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+CONFIG(release, debug|release): NFCORE_DIR = $$OUT_PWD/../core/release
+CONFIG(debug, debug|release): NFCORE_DIR = $$OUT_PWD/../core/debug
+LIBS += -L$$NFCORE_DIR -lnfcore
+
+win32-msvc*: PRE_TARGETDEPS += $$NFCORE_DIR/nfcore.lib
+else: PRE_TARGETDEPS += $$NFCORE_DIR/libnfcore.a
@@ -0,0 +1,57 @@
+include(../common.pri)
+
+# QtGui is only needed for QColor, QImage and the QVectorND types,
+# none of which require a windowing system or a QGuiApplication
+QT = core gui concurrent
+
+TARGET = nfcore
+TEMPLATE = lib
+CONFIG += staticlib
+
+CONFIG(release, debug|release): DESTDIR = release
+CONFIG(debug, debug|release): DESTDIR = debug
+
+SOURCES += \
+    densitymap.cpp \
+    equalizer.cpp \
+    expression.cpp \
+    framebudget.cpp \
+    imageline.cpp \
+    kernelcache.cpp \
+    limits.cpp \
+    newton.cpp \
+    orbitfield.cpp \
+    parameters.cpp \
+    perfcounters.cpp \
+    perturbation.cpp \
+    renderer.cpp \
+    renderstats.cpp \
+    root.cpp \
+    rootclusters.cpp \
+    roottable.cpp \
+    snapshot.cpp \
+    symmetry.cpp \
+    tracer.cpp
+
+HEADERS += \
+    defaults.h \
+    densitymap.h \
+    equalizer.h \
+    expression.h \
+    framebudget.h \
+    imageline.h \
+    kernelcache.h \
+    limits.h \
+    newton.h \
+    orbitfield.h \
+    parameters.h \
+    perfcounters.h \
+    perturbation.h \
+    renderer.h \
+    renderstats.h \
+    root.h \
+    rootclusters.h \
+    roottable.h \
+    snapshot.h \
+    symmetry.h \
+    tracer.h
@@ -0,0 +1,72 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef DEFAULTS_H
+#define DEFAULTS_H
+
+#include <complex>
+#include <QVector>
+#include <QColor>
+
+typedef std::complex<double> complex;
+
+namespace nf {
+	static constexpr double  PI  = 3.141592653589793238463;	// Pi as a constexpr
+
+	static constexpr double  EPS = 1e-3;					// Max error allowed
+	static constexpr quint8  RIR = 5;						// Root indicator radius
+	static constexpr quint8  OIR = 3;						// Orbit point indicator radius
+	static constexpr int     OFG = 24;						// Orbit field grid spacing in pixels
+	static constexpr int     OFS = 24;						// Orbit field steps per orbit
+	static constexpr double  DMG = 0.5;						// Density map margin of starts around the view, in views
+	static constexpr double  DMS = 1.0;						// Density map start spacing in pixels
+	static constexpr double  MOD = 0.2;						// Root drag speed modifier
+	static constexpr double  ZMF = 0.05;					// Zoom factor
+	static constexpr double  FLT = 1e-5;					// Relative pixel spacing to switch to float
+	static constexpr int     FLN = 8;						// Float kernel lanes
+	static constexpr double  DDT = 1e-13;					// Relative pixel spacing to switch to double-double
+	static constexpr double  PRT = 1e-3;					// Perturbation delta to rebase to plain double
+	static constexpr double  GLT = 1e-3;					// Perturbation glitch tolerance
+	static constexpr double  SYT = 1e-9;					// Relative root distance to treat a layout as symmetric
+	static constexpr double  SYP = 1e-6;					// Distance in pixels of a turned or mirrored pixel to the grid
+	static constexpr int     EQD = 400;						// Darker factor of the last pixels of equalised coloring
+	static constexpr quint16 AAI = 4;						// Iteration difference that makes a pixel an edge
+	static constexpr int     RIF = 8;						// Factor idle refinement raises max. iterations by
+	static constexpr double  PFM = 0.25;					// Margin prefetched around the view while idle
+	static constexpr double  MSC = 0.1;						// Minimum scaledown factor of the frame budget
+	static constexpr double  SCG = 1.5;						// Growth of the scale per frame back to full size
+	static constexpr double  SMO = 0.5;						// Weight of a faster frame in the frame time estimate
+	static constexpr quint16 MIC = 16;						// Minimum iteration cap of the frame budget
+	static constexpr int     EXS = 32;						// Maximum stack depth of a custom function
+	static constexpr int     EXN = 8 * EXS;				// Maximum nesting of a custom function while parsing
+	static constexpr int     EXI = 64;						// Largest integer power compiled to repeated squaring
+	static constexpr int     KCT = 30000;					// Milliseconds the compiler may take for a custom function
+	static constexpr double  CLT = 1e-2;					// Distance of converged points that belong to the same root
+	static constexpr quint16 MRC = 1000;					// Maximum root count
+	static constexpr int     SRC = 10;						// Root count of the float and perturbation kernels, more use a RootTable
+	static constexpr int     GRC = 64;						// Maximum root count of the OpenGL renderer
+	static constexpr quint8  PCC = 10;						// Number of predefined colors
+
+	static constexpr quint8  DRC = 5;						// Default root count
+	static constexpr double  DSC = 0.5;						// Default scaledown factor
+	static constexpr complex DDP = complex(1, 0);			// Default damping factor
+	static constexpr quint16 DTI = 400;						// Default timer interval
+	static constexpr double  DRR = 60;						// Default display refresh rate
+	static constexpr double  DFB = 33;						// Default frame time budget in ms
+	static constexpr quint16 DMI = 160;						// Default max. iterations
+	static constexpr quint16 DSI = 700;						// Default size
+	static constexpr quint16 MSI = 128;						// Minimum size
+	static constexpr quint16 DZS = 2;						// Default complex size [-DZS -> +DZS]
+	static constexpr double  DSF = 0.5 * DZS / DSI;			// Resulting size factor
+
+	static const QColor predefColors[PCC] = {
+		Qt::red, Qt::green, Qt::blue,
+		Qt::cyan, Qt::magenta, Qt::yellow,
+		QColor(255, 128, 0), QColor(128, 0, 255), QColor(0, 255, 128), QColor(128, 128, 128)
+	};
+}
+
+
+#endif // DEFAULTS_H
@@ -0,0 +1,146 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "densitymap.h"
+#include "newton.h"
+#include <QtMath>
+#include <cmath>
+
+static inline quint32 jitter(quint32 n)
+{
+	// Integer hash, the same start gets the same offset every frame
+	n ^= n >> 16;
+	n *= 0x7feb352d;
+	n ^= n >> 15;
+	n *= 0x846ca68b;
+	n ^= n >> 16;
+	return n;
+}
+
+DensityMap::DensityMap() :
+	width_(0),
+	height_(0),
+	columns_(0),
+	rows_(0),
+	left_(0),
+	top_(0),
+	xFactor_(0),
+	yFactor_(0),
+	startX_(0),
+	startY_(0),
+	scale_(0)
+{
+}
+
+DensityMap::DensityMap(const Parameters &params, QSize size, int chunks) :
+	DensityMap()
+{
+	// Pixel grid of the frame
+	Expression expression = Expression::compile(params.function);
+	if ((expression.isEmpty() && params.roots.count() < 2) || size.width() < 2 || size.height() < 2) return;
+	params_ = params;
+	expression_ = expression;
+	width_ = size.width();
+	height_ = size.height();
+	left_ = params.limits.left();
+	top_ = params.limits.top();
+	xFactor_ = params.limits.width() / (width_ - 1);
+	yFactor_ = -params.limits.height() / (height_ - 1);
+
+	// Starts cover the view and the margin, orbits from outside pass through
+	columns_ = qCeil(width_ * (1 + 2 * nf::DMG) / nf::DMS);
+	rows_ = qCeil(height_ * (1 + 2 * nf::DMG) / nf::DMS);
+	startX_ = -nf::DMG * width_;
+	startY_ = -nf::DMG * height_;
+
+	// One buffer per chunk, so accumulating needs no locks
+	buffers_.resize(qMax(1, chunks));
+	for (QVector<quint32> &buffer : buffers_) buffer.fill(0, width_ * height_);
+	rowMax_.fill(0, height_);
+}
+
+bool DensityMap::isEmpty() const
+{
+	// Nothing to accumulate into
+	return buffers_.isEmpty();
+}
+
+int DensityMap::chunks() const
+{
+	// Number of accumulation buffers
+	return buffers_.size();
+}
+
+void DensityMap::accumulate(int chunk)
+{
+	// Rows of starts interleave across chunks so they take about as long
+	quint32 *buffer = buffers_[chunk].data();
+	const int chunks = buffers_.size();
+	const complex d = params_.damping;
+	for (int row = chunk; row < rows_; row += chunks) {
+		for (int column = 0; column < columns_; ++column) {
+			const quint32 h = jitter(quint32(row) * quint32(columns_) + quint32(column));
+			const double sx = startX_ + (column + (h & 0xffff) / 65536.0) * nf::DMS;
+			const double sy = startY_ + (row + (h >> 16) / 65536.0) * nf::DMS;
+			complex z(sx * xFactor_ + left_, sy * yFactor_ + top_);
+
+			// Count every iterate in the pixel it lands in, the start itself is not
+			for (quint16 i = 0; i < params_.maxIterations; ++i) {
+				complex q;
+				if (expression_.isEmpty()) {
+					q = quotient(z, params_.roots);
+				} else {
+					complex f, df;
+					expression_.evaluate(z, f, df);
+					q = f / df;
+				}
+				complex z0 = z - d * q;
+				if (!std::isfinite(z0.real()) || !std::isfinite(z0.imag())) break;
+
+				// Reject iterates outside the view before rounding, far steps
+				// near critical points do not fit into an int
+				const double px = (z0.real() - left_) / xFactor_;
+				const double py = (z0.imag() - top_) / yFactor_;
+				if (px > -0.5 && py > -0.5 && px < width_ - 0.5 && py < height_ - 0.5) buffer[qRound(py) * width_ + qRound(px)]++;
+				if (abs(z0 - z) < nf::EPS) break;
+				z = z0;
+			}
+		}
+	}
+}
+
+void DensityMap::reduce(int row)
+{
+	// Sum a row of all buffers into the first one
+	quint32 *sum = buffers_[0].data() + row * width_;
+	for (int c = 1; c < buffers_.size(); ++c) {
+		const quint32 *part = buffers_[c].constData() + row * width_;
+		for (int x = 0; x < width_; ++x) sum[x] += part[x];
+	}
+	quint32 most = 0;
+	for (int x = 0; x < width_; ++x) most = qMax(most, sum[x]);
+	rowMax_[row] = most;
+}
+
+void DensityMap::normalize()
+{
+	// Most hits of the frame map to white
+	quint32 most = 0;
+	for (quint32 m : rowMax_) most = qMax(most, m);
+	scale_ = most > 0 ? 1.0 / std::log1p(double(most)) : 0;
+}
+
+void DensityMap::toneMap(ImageLine &il) const
+{
+	// Logarithmic black, red, yellow, white ramp
+	const quint32 *sum = buffers_[0].constData() + il.lineIndex * width_;
+	for (int x = 0; x < il.lineSize; ++x) {
+		const double t = 3 * std::log1p(double(sum[x])) * scale_;
+		const int r = qRound(255 * qBound(0.0, t, 1.0));
+		const int g = qRound(255 * qBound(0.0, t - 1, 1.0));
+		const int b = qRound(255 * qBound(0.0, t - 2, 1.0));
+		il.scanLine[x] = qRgb(r, g, b);
+	}
+}
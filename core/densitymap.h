@@ -0,0 +1,51 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef DENSITYMAP_H
+#define DENSITYMAP_H
+
+#include "parameters.h"
+#include "imageline.h"
+#include "expression.h"
+
+// Where newton orbits travel, a histogram of every iterate of many start
+// points like the buddhabrot. Starts lie on a grid every nf::DMS pixels over
+// the view and a margin of nf::DMG views on each side, each jittered within
+// its cell so the grid does not alias. Every chunk of starts accumulates into
+// a buffer of its own, there is one chunk per thread. The rows of the buffers
+// are then summed in parallel and tone mapped logarithmically. Double
+// precision only, custom functions are evaluated by their bytecode.
+
+class DensityMap
+{
+public:
+	DensityMap();
+	DensityMap(const Parameters &params, QSize size, int chunks);
+	bool isEmpty() const;
+	int chunks() const;
+	void accumulate(int chunk);
+	void reduce(int row);
+	void normalize();
+	void toneMap(ImageLine &il) const;
+
+private:
+	Parameters params_;
+	Expression expression_;			// Custom f(z), empty for the roots
+	int width_;
+	int height_;
+	int columns_;					// Start grid
+	int rows_;
+	double left_;					// Pixel grid of the frame, same mapping as iterateX
+	double top_;
+	double xFactor_;
+	double yFactor_;
+	double startX_;					// First start cell in pixels
+	double startY_;
+	QVector<QVector<quint32>> buffers_;	// Hits per pixel and chunk, the first one receives the sum
+	QVector<quint32> rowMax_;		// Most hits per row after reducing
+	double scale_;					// 1 / log(1 + most hits)
+};
+
+#endif // DENSITYMAP_H
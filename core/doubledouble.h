@@ -0,0 +1,151 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef DOUBLEDOUBLE_H
+#define DOUBLEDOUBLE_H
+
+#include "defaults.h"
+
+// Double-double arithmetic: a value is the unevaluated sum hi + lo of two
+// doubles with |lo| <= ulp(hi) / 2, which gives about 106 bits of mantissa.
+// All operations are branch free and only need IEEE rounding, the splitting
+// product does not rely on a hardware fma. Do not build with -ffast-math.
+
+struct ddouble {
+	ddouble() : hi(0), lo(0) {}
+	ddouble(double hi) : hi(hi), lo(0) {}
+	ddouble(double hi, double lo) : hi(hi), lo(lo) {}
+	double hi;
+	double lo;
+};
+
+namespace dd {
+	inline ddouble quickTwoSum(double a, double b)
+	{
+		// Exact sum if |a| >= |b|
+		double s = a + b;
+		return ddouble(s, b - (s - a));
+	}
+
+	inline ddouble twoSum(double a, double b)
+	{
+		// Exact sum of two doubles
+		double s = a + b;
+		double v = s - a;
+		return ddouble(s, (a - (s - v)) + (b - v));
+	}
+
+	inline ddouble twoProd(double a, double b)
+	{
+		// Exact product of two doubles using Dekker's split
+		static constexpr double SPLIT = 134217729.0; // 2^27 + 1
+		double p = a * b;
+		double ta = SPLIT * a, tb = SPLIT * b;
+		double ah = ta - (ta - a), al = a - ah;
+		double bh = tb - (tb - b), bl = b - bh;
+		return ddouble(p, ((ah * bh - p) + ah * bl + al * bh) + al * bl);
+	}
+}
+
+inline ddouble operator+(ddouble a, ddouble b)
+{
+	// IEEE style addition
+	ddouble s = dd::twoSum(a.hi, b.hi);
+	ddouble t = dd::twoSum(a.lo, b.lo);
+	s.lo += t.hi;
+	s = dd::quickTwoSum(s.hi, s.lo);
+	s.lo += t.lo;
+	return dd::quickTwoSum(s.hi, s.lo);
+}
+
+inline ddouble operator-(ddouble a)
+{
+	// Negation
+	return ddouble(-a.hi, -a.lo);
+}
+
+inline ddouble operator-(ddouble a, ddouble b)
+{
+	// Subtraction
+	return a + (-b);
+}
+
+inline ddouble operator*(ddouble a, ddouble b)
+{
+	// Multiplication
+	ddouble p = dd::twoProd(a.hi, b.hi);
+	p.lo += a.hi * b.lo + a.lo * b.hi;
+	return dd::quickTwoSum(p.hi, p.lo);
+}
+
+inline ddouble operator*(ddouble a, double b)
+{
+	// Multiplication by a double
+	ddouble p = dd::twoProd(a.hi, b);
+	p.lo += a.lo * b;
+	return dd::quickTwoSum(p.hi, p.lo);
+}
+
+inline ddouble operator/(ddouble a, ddouble b)
+{
+	// Division with one correction step
+	double q1 = a.hi / b.hi;
+	ddouble r = a - b * q1;
+	double q2 = r.hi / b.hi;
+	r = r - b * q2;
+	double q3 = r.hi / b.hi;
+	return dd::quickTwoSum(q1, q2) + ddouble(q3);
+}
+
+inline ddouble &operator+=(ddouble &a, ddouble b) { return a = a + b; }
+inline ddouble &operator-=(ddouble &a, ddouble b) { return a = a - b; }
+inline ddouble &operator*=(ddouble &a, ddouble b) { return a = a * b; }
+inline bool operator==(ddouble a, ddouble b) { return a.hi == b.hi && a.lo == b.lo; }
+inline bool operator!=(ddouble a, ddouble b) { return a.hi != b.hi || a.lo != b.lo; }
+
+struct ddcomplex {
+	ddcomplex() {}
+	ddcomplex(ddouble re, ddouble im) : re(re), im(im) {}
+	ddcomplex(complex z) : re(z.real()), im(z.imag()) {}
+	complex toComplex() const { return complex(re.hi, im.hi); }
+	ddouble re;
+	ddouble im;
+};
+
+inline ddcomplex operator+(const ddcomplex &a, const ddcomplex &b)
+{
+	// Complex addition
+	return ddcomplex(a.re + b.re, a.im + b.im);
+}
+
+inline ddcomplex operator-(const ddcomplex &a, const ddcomplex &b)
+{
+	// Complex subtraction
+	return ddcomplex(a.re - b.re, a.im - b.im);
+}
+
+inline ddcomplex operator*(const ddcomplex &a, const ddcomplex &b)
+{
+	// Complex multiplication
+	return ddcomplex(a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re);
+}
+
+inline ddcomplex operator*(const ddcomplex &a, complex b)
+{
+	// Multiplication by a double complex, e.g. damping
+	return ddcomplex(a.re * b.real() - a.im * b.imag(), a.re * b.imag() + a.im * b.real());
+}
+
+inline ddcomplex operator/(const ddcomplex &a, const ddcomplex &b)
+{
+	// Complex division by multiplying with the conjugate
+	ddouble n = b.re * b.re + b.im * b.im;
+	return ddcomplex((a.re * b.re + a.im * b.im) / n, (a.im * b.re - a.re * b.im) / n);
+}
+
+inline ddcomplex &operator+=(ddcomplex &a, const ddcomplex &b) { return a = a + b; }
+inline ddcomplex &operator*=(ddcomplex &a, const ddcomplex &b) { return a = a * b; }
+
+#endif // DOUBLEDOUBLE_H
@@ -0,0 +1,88 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "equalizer.h"
+
+Equalizer::Equalizer() :
+	width_(0),
+	height_(0),
+	levels_(0)
+{
+}
+
+Equalizer::Equalizer(const Parameters &params, QSize size, quint16 iterations, int chunks) :
+	Equalizer()
+{
+	// One histogram per chunk, so counting needs no locks
+	for (const Root &root : params.roots) colors_.append(root.color());
+	width_ = size.width();
+	height_ = size.height();
+	levels_ = iterations + 1;
+	histograms_.resize(qMax(1, chunks));
+	for (QVector<quint32> &histogram : histograms_) histogram.fill(0, colors_.size() * levels_);
+}
+
+bool Equalizer::isEmpty() const
+{
+	// Nothing to count into
+	return histograms_.isEmpty();
+}
+
+int Equalizer::chunks() const
+{
+	// Number of histograms
+	return histograms_.size();
+}
+
+void Equalizer::count(int chunk, const Pixel *pixels)
+{
+	// Rows interleave across chunks, unconverged pixels stay black
+	quint32 *histogram = histograms_[chunk].data();
+	for (int y = chunk; y < height_; y += histograms_.size()) {
+		const Pixel *line = pixels + y * width_;
+		for (int x = 0; x < width_; ++x) {
+			if (line[x].root >= 0) histogram[line[x].root * levels_ + qMin<int>(line[x].iteration, levels_ - 1)]++;
+		}
+	}
+}
+
+void Equalizer::equalize()
+{
+	// Sum the histograms of all chunks into the first one
+	QVector<quint32> &sum = histograms_[0];
+	for (int c = 1; c < histograms_.size(); ++c) {
+		for (int i = 0; i < sum.size(); ++i) sum[i] += histograms_[c][i];
+	}
+
+	// Rank in the middle of the pixels of each level picks the shade
+	table_.resize(sum.size());
+	for (int r = 0; r < colors_.size(); ++r) {
+		const quint32 *histogram = sum.constData() + r * levels_;
+		quint64 total = 0;
+		for (int i = 0; i < levels_; ++i) total += histogram[i];
+		quint64 below = 0;
+		for (int i = 0; i < levels_; ++i) {
+			const double rank = total > 0 ? (below + 0.5 * histogram[i]) / total : 0;
+			table_[r * levels_ + i] = colors_[r].darker(60 + qRound(rank * (nf::EQD - 60))).rgb();
+			below += histogram[i];
+		}
+	}
+}
+
+void Equalizer::apply(ImageLine &il, const Pixel *pixels) const
+{
+	// Recolor a line from its pixel state
+	const Pixel *line = pixels + il.lineIndex * width_;
+	for (int x = il.begin; x < il.end; ++x) {
+		il.scanLine[x - il.begin] = color(line[x].root, line[x].iteration);
+	}
+}
+
+QRgb Equalizer::color(int root, quint16 iteration) const
+{
+	// Same black as rootColor if not converged
+	if (root < 0) return qRgb(0, 0, 0);
+	return table_[root * levels_ + qMin<int>(iteration, levels_ - 1)];
+}
@@ -0,0 +1,41 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include "parameters.h"
+#include "imageline.h"
+#include <QRgb>
+
+// Histogram equalised shading. The iterations of converged pixels are counted
+// per root, every chunk of rows into a histogram of its own, there is one
+// chunk per thread. The summed histograms map every iteration count to its
+// rank among the pixels of its root, so shades spread evenly over every basin
+// whatever maxIterations or zoom. Colors come from a table, recoloring a frame
+// needs no iterations.
+
+class Equalizer
+{
+public:
+	Equalizer();
+	Equalizer(const Parameters &params, QSize size, quint16 iterations, int chunks);
+	bool isEmpty() const;
+	int chunks() const;
+	void count(int chunk, const Pixel *pixels);
+	void equalize();
+	void apply(ImageLine &il, const Pixel *pixels) const;
+	QRgb color(int root, quint16 iteration) const;
+
+private:
+	QVector<QColor> colors_;
+	int width_;
+	int height_;
+	int levels_;					// Iteration counts per root, iterations + 1
+	QVector<QVector<quint32>> histograms_;	// Pixels per root and iteration of every chunk
+	QVector<QRgb> table_;			// Color per root and iteration
+};
+
+#endif // EQUALIZER_H
@@ -0,0 +1,565 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "expression.h"
+#include <QStringList>
+#include <cmath>
+
+class Parser
+{
+public:
+	Parser(const QString &text, QVector<Instruction> &code, QVector<complex> &constants) :
+		text_(text),
+		pos_(0),
+		depth_(0),
+		code_(code),
+		constants_(constants)
+	{
+	}
+
+	bool parse()
+	{
+		// Whole text must be a single sum
+		if (!sum()) return false;
+		skip();
+		if (pos_ < text_.size()) return fail(QString("unexpected '%1'").arg(text_[pos_]));
+		return true;
+	}
+
+	QString error;
+
+private:
+	void skip()
+	{
+		// Ignore white space
+		while (pos_ < text_.size() && text_[pos_].isSpace()) ++pos_;
+	}
+
+	bool fail(const QString &message)
+	{
+		// First error wins
+		if (error.isEmpty()) error = QString("%1 at position %2").arg(message).arg(pos_ + 1);
+		return false;
+	}
+
+	void emitConstant(complex c)
+	{
+		// Constants live in a table, the instruction refers to it
+		constants_.append(c);
+		code_.append({OP_CONST, constants_.size() - 1});
+	}
+
+	bool constantSince(int start, complex &c) const
+	{
+		// Code emitted since start is a single constant
+		if (code_.size() != start + 1 || code_.last().op != OP_CONST) return false;
+		c = constants_[code_.last().arg];
+		return true;
+	}
+
+	bool startsFactor()
+	{
+		// Next token can follow a factor without an operator in between
+		skip();
+		if (pos_ >= text_.size()) return false;
+		const QChar c = text_[pos_];
+		return c.isDigit() || c == '.' || c.isLetter() || c == '(';
+	}
+
+	bool sum()
+	{
+		// Terms joined by + and -
+		if (!product()) return false;
+		for (;;) {
+			skip();
+			if (pos_ >= text_.size()) return true;
+			const QChar c = text_[pos_];
+			if (c != '+' && c != '-') return true;
+			++pos_;
+			if (!product()) return false;
+			code_.append({c == '+' ? OP_ADD : OP_SUB, 0});
+		}
+	}
+
+	bool product()
+	{
+		// Factors joined by *, / or nothing
+		if (!unary()) return false;
+		for (;;) {
+			skip();
+			if (pos_ >= text_.size()) return true;
+			const QChar c = text_[pos_];
+			if (c == '*' || c == '/') ++pos_;
+			else if (!startsFactor()) return true;
+			if (!unary()) return false;
+			code_.append({c == '/' ? OP_DIV : OP_MUL, 0});
+		}
+	}
+
+	bool unary()
+	{
+		// Every nesting of signs, exponents, parentheses and calls passes
+		// here, bounded so pasted text cannot overflow the stack
+		if (depth_ >= nf::EXN) return fail("expression too deep");
+		++depth_;
+		const bool ok = sign();
+		--depth_;
+		return ok;
+	}
+
+	bool sign()
+	{
+		// Signs, negated constants are folded
+		skip();
+		if (pos_ < text_.size() && (text_[pos_] == '-' || text_[pos_] == '+')) {
+			const bool negate = text_[pos_] == '-';
+			++pos_;
+			const int start = code_.size();
+			if (!unary()) return false;
+			complex c;
+			if (!negate) return true;
+			if (constantSince(start, c)) {
+				code_.removeLast();
+				emitConstant(-c);
+			} else code_.append({OP_NEG, 0});
+			return true;
+		}
+		return power();
+	}
+
+	bool power()
+	{
+		// Right associative, small integer exponents use repeated squaring
+		if (!primary()) return false;
+		skip();
+		if (pos_ >= text_.size() || text_[pos_] != '^') return true;
+		++pos_;
+		const int start = code_.size();
+		if (!unary()) return false;
+		complex c;
+		if (constantSince(start, c) && c.imag() == 0 && c.real() == std::round(c.real()) && qAbs(c.real()) <= nf::EXI) {
+			code_.removeLast();
+			code_.append({OP_POWI, int(c.real())});
+		} else code_.append({OP_POW, 0});
+		return true;
+	}
+
+	bool primary()
+	{
+		// Number, name, function call or parentheses
+		skip();
+		if (pos_ >= text_.size()) return fail("unexpected end");
+		const QChar c = text_[pos_];
+		if (c.isDigit() || c == '.') return number();
+		if (c == '(') {
+			++pos_;
+			if (!sum()) return false;
+			skip();
+			if (pos_ >= text_.size() || text_[pos_] != ')') return fail("missing ')'");
+			++pos_;
+			return true;
+		}
+		if (!c.isLetter()) return fail(QString("unexpected '%1'").arg(c));
+
+		// Names
+		const int start = pos_;
+		while (pos_ < text_.size() && text_[pos_].isLetter()) ++pos_;
+		const QString name = text_.mid(start, pos_ - start).toLower();
+		if (name == "z") code_.append({OP_Z, 0});
+		else if (name == "i") emitConstant(complex(0, 1));
+		else if (name == "pi") emitConstant(nf::PI);
+		else if (name == "e") emitConstant(std::exp(1.0));
+		else {
+			static const QStringList names = {"exp", "log", "sqrt", "sin", "cos", "tan", "sinh", "cosh", "tanh"};
+			static const OpCode ops[] = {OP_EXP, OP_LOG, OP_SQRT, OP_SIN, OP_COS, OP_TAN, OP_SINH, OP_COSH, OP_TANH};
+			const int index = names.indexOf(name);
+			if (index < 0) {
+				pos_ = start;
+				return fail(QString("unknown name '%1'").arg(name));
+			}
+			skip();
+			if (pos_ >= text_.size() || text_[pos_] != '(') return fail(QString("'(' expected after %1").arg(name));
+			if (!primary()) return false;
+			code_.append({ops[index], 0});
+		}
+		return true;
+	}
+
+	bool number()
+	{
+		// Decimal number with optional exponent, 2e is two times e
+		const int start = pos_;
+		while (pos_ < text_.size() && (text_[pos_].isDigit() || text_[pos_] == '.')) ++pos_;
+		if (pos_ + 1 < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+			int p = pos_ + 1;
+			if (text_[p] == '+' || text_[p] == '-') ++p;
+			if (p < text_.size() && text_[p].isDigit()) {
+				pos_ = p;
+				while (pos_ < text_.size() && text_[pos_].isDigit()) ++pos_;
+			}
+		}
+		bool ok;
+		const double value = text_.mid(start, pos_ - start).toDouble(&ok);
+		if (!ok) {
+			pos_ = start;
+			return fail("invalid number");
+		}
+		emitConstant(value);
+		return true;
+	}
+
+	const QString &text_;
+	int pos_;
+	int depth_;
+	QVector<Instruction> &code_;
+	QVector<complex> &constants_;
+};
+
+static inline void apply(OpCode op, complex a, complex da, complex &v, complex &d)
+{
+	// Value and derivative of a function of a, chain rule with da
+	switch (op) {
+	case OP_EXP: v = std::exp(a); d = v * da; break;
+	case OP_LOG: v = std::log(a); d = da / a; break;
+	case OP_SQRT: v = std::sqrt(a); d = da / (2.0 * v); break;
+	case OP_SIN: v = std::sin(a); d = std::cos(a) * da; break;
+	case OP_COS: v = std::cos(a); d = -std::sin(a) * da; break;
+	case OP_TAN: v = std::tan(a); d = (1.0 + v * v) * da; break;
+	case OP_SINH: v = std::sinh(a); d = std::cosh(a) * da; break;
+	case OP_COSH: v = std::cosh(a); d = std::sinh(a) * da; break;
+	case OP_TANH: v = std::tanh(a); d = (1.0 - v * v) * da; break;
+	default: v = a; d = da; break;
+	}
+}
+
+static inline void powi(complex a, complex da, int n, complex &v, complex &d)
+{
+	// a^n by repeated squaring, derivative n a^(n-1) da
+	if (n == 0) {
+		v = 1;
+		d = 0;
+		return;
+	}
+	complex p(1, 0), base = a;
+	for (int e = qAbs(n) - 1; e > 0; e >>= 1) {
+		if (e & 1) p *= base;
+		base *= base;
+	}
+	if (n > 0) {
+		v = p * a;
+		d = double(n) * p * da;
+	} else {
+		v = 1.0 / (p * a);
+		d = double(n) * v / a * da;
+	}
+}
+
+Expression::Expression() :
+	native_(nullptr)
+{
+}
+
+Expression Expression::compile(const QString &text, QString *error)
+{
+	// Empty text compiles to an empty expression without error
+	Expression expression;
+	if (error != nullptr) error->clear();
+	if (text.trimmed().isEmpty()) return expression;
+	Parser parser(text, expression.code_, expression.constants_);
+	bool ok = parser.parse();
+
+	// The stack must stay within nf::EXS values
+	int depth = 0;
+	for (const Instruction &in : expression.code_) {
+		if (in.op == OP_Z || in.op == OP_CONST) depth++;
+		else if (in.op <= OP_DIV || in.op == OP_POW) depth--;
+		if (depth > nf::EXS && parser.error.isEmpty()) parser.error = "expression too long";
+	}
+	if (!ok || !parser.error.isEmpty()) {
+		if (error != nullptr) *error = parser.error;
+		return Expression();
+	}
+	expression.text_ = text.trimmed();
+	return expression;
+}
+
+bool Expression::isEmpty() const
+{
+	// Nothing compiled
+	return code_.isEmpty();
+}
+
+QString Expression::text() const
+{
+	// Source of the bytecode
+	return text_;
+}
+
+int Expression::size() const
+{
+	// Number of instructions
+	return code_.size();
+}
+
+static QString number(double value)
+{
+	// Shortest text that reads back as the same double
+	return QString::number(value, 'g', 17);
+}
+
+static QString fill(QString line, const QStringList &names)
+{
+	// %1 to %6 are value and derivative of the result and both operands
+	for (int n = 0; n < names.size(); ++n) line.replace("%" + QString::number(n + 1), names[n]);
+	return line;
+}
+
+QString Expression::source() const
+{
+	// One value and one derivative variable per instruction, the stack only
+	// decides which variables an instruction reads
+	QStringList body;
+	QVector<int> stack;
+	for (int k = 0; k < code_.size(); ++k) {
+		const Instruction &in = code_[k];
+		QStringList names = {QString("v%1").arg(k), QString("d%1").arg(k), "", "", "", ""};
+		if ((in.op >= OP_ADD && in.op <= OP_DIV) || in.op == OP_POW) {
+			names[4] = QString("v%1").arg(stack.last());
+			names[5] = QString("d%1").arg(stack.takeLast());
+		}
+		if (in.op != OP_Z && in.op != OP_CONST) {
+			names[2] = QString("v%1").arg(stack.last());
+			names[3] = QString("d%1").arg(stack.takeLast());
+		}
+		stack.append(k);
+		const QString p = QString("p%1").arg(k);
+		QString line;
+		switch (in.op) {
+		case OP_Z: line = "const C %1 = z, %2(1, 0);"; break;
+		case OP_CONST:
+			line = "const C %1(" + number(constants_[in.arg].real()) + ", " + number(constants_[in.arg].imag()) + "), %2(0, 0);";
+			break;
+		case OP_ADD: line = "const C %1 = %3 + %5, %2 = %4 + %6;"; break;
+		case OP_SUB: line = "const C %1 = %3 - %5, %2 = %4 - %6;"; break;
+		case OP_MUL: line = "const C %1 = mul(%3, %5), %2 = mul(%4, %5) + mul(%3, %6);"; break;
+		case OP_DIV: line = "const C %1 = dvd(%3, %5), %2 = dvd(%4 - mul(%1, %6), %5);"; break;
+		case OP_NEG: line = "const C %1 = -%3, %2 = -%4;"; break;
+		case OP_POWI:
+			if (in.arg == 0) line = "const C %1(1, 0), %2(0, 0);";
+			else if (in.arg > 0) line = "const C " + p + " = powi(%3, " + QString::number(in.arg - 1) + "), %1 = mul(" + p +
+				", %3), %2 = double(" + QString::number(in.arg) + ") * mul(" + p + ", %4);";
+			else line = "const C " + p + " = powi(%3, " + QString::number(-in.arg - 1) + "), %1 = dvd(C(1, 0), mul(" + p +
+				", %3)), %2 = double(" + QString::number(in.arg) + ") * dvd(mul(%1, %4), %3);";
+			break;
+		case OP_POW: line = "const C " + p + " = std::log(%3), %1 = std::exp(mul(%5, " + p + ")), %2 = mul(%1, mul(%6, " + p +
+			") + dvd(mul(%5, %4), %3));"; break;
+		case OP_EXP: line = "const C %1 = std::exp(%3), %2 = mul(%1, %4);"; break;
+		case OP_LOG: line = "const C %1 = std::log(%3), %2 = dvd(%4, %3);"; break;
+		case OP_SQRT: line = "const C %1 = std::sqrt(%3), %2 = dvd(%4, 2.0 * %1);"; break;
+		case OP_SIN: line = "const C %1 = std::sin(%3), %2 = mul(std::cos(%3), %4);"; break;
+		case OP_COS: line = "const C %1 = std::cos(%3), %2 = -mul(std::sin(%3), %4);"; break;
+		case OP_TAN: line = "const C %1 = std::tan(%3), %2 = mul(1.0 + mul(%1, %1), %4);"; break;
+		case OP_SINH: line = "const C %1 = std::sinh(%3), %2 = mul(std::cosh(%3), %4);"; break;
+		case OP_COSH: line = "const C %1 = std::cosh(%3), %2 = mul(std::sinh(%3), %4);"; break;
+		case OP_TANH: line = "const C %1 = std::tanh(%3), %2 = mul(1.0 - mul(%1, %1), %4);"; break;
+		}
+		body.append("\t\t" + fill(line, names));
+	}
+
+	// Complex products without the NaN checks of std::complex, like the interpreter
+	const QString last = QString::number(code_.size() - 1);
+	return
+		"// f(z) = " + text_.simplified() + "\n"
+		"#include <complex>\n"
+		"#ifdef _WIN32\n"
+		"#define NF_EXPORT __declspec(dllexport)\n"
+		"#else\n"
+		"#define NF_EXPORT __attribute__((visibility(\"default\")))\n"
+		"#endif\n"
+		"typedef std::complex<double> C;\n"
+		"static inline C mul(C a, C b) { return C(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()); }\n"
+		"static inline C dvd(C a, C b) { const double n = b.real() * b.real() + b.imag() * b.imag(); "
+		"return C((a.real() * b.real() + a.imag() * b.imag()) / n, (a.imag() * b.real() - a.real() * b.imag()) / n); }\n"
+		"static inline C powi(C a, int n) { C p(1, 0); for (; n > 0; n >>= 1) { if (n & 1) p = mul(p, a); a = mul(a, a); } return p; }\n"
+		"extern \"C\" NF_EXPORT void nf_function(const double *zx, const double *zy, double *fx, double *fy, double *dfx, double *dfy)\n"
+		"{\n"
+		"\tfor (int l = 0; l < " + QString::number(nf::FLN) + "; ++l) {\n"
+		"\t\tconst C z(zx[l], zy[l]);\n" +
+		body.join("\n") + "\n"
+		"\t\tfx[l] = v" + last + ".real();\n"
+		"\t\tfy[l] = v" + last + ".imag();\n"
+		"\t\tdfx[l] = d" + last + ".real();\n"
+		"\t\tdfy[l] = d" + last + ".imag();\n"
+		"\t}\n"
+		"}\n";
+}
+
+bool Expression::isNative() const
+{
+	// Batches run compiled code
+	return native_ != nullptr;
+}
+
+void Expression::setNative(NativeFunction native)
+{
+	// Compiled batch evaluation of this expression, nullptr interprets again
+	native_ = native;
+}
+
+void Expression::evaluate(complex z, complex &f, complex &df) const
+{
+	// Value and derivative of a single point
+	complex v[nf::EXS], d[nf::EXS];
+	int top = -1;
+	for (const Instruction &in : code_) {
+		switch (in.op) {
+		case OP_Z: ++top; v[top] = z; d[top] = 1; break;
+		case OP_CONST: ++top; v[top] = constants_[in.arg]; d[top] = 0; break;
+		case OP_ADD: --top; v[top] += v[top + 1]; d[top] += d[top + 1]; break;
+		case OP_SUB: --top; v[top] -= v[top + 1]; d[top] -= d[top + 1]; break;
+		case OP_MUL: --top; d[top] = d[top] * v[top + 1] + v[top] * d[top + 1]; v[top] *= v[top + 1]; break;
+		case OP_DIV: --top; v[top] /= v[top + 1]; d[top] = (d[top] - v[top] * d[top + 1]) / v[top + 1]; break;
+		case OP_NEG: v[top] = -v[top]; d[top] = -d[top]; break;
+		case OP_POWI: powi(v[top], d[top], in.arg, v[top], d[top]); break;
+		case OP_POW: {
+			--top;
+			const complex a = v[top], b = v[top + 1], la = std::log(a);
+			v[top] = std::exp(b * la);
+			d[top] = v[top] * (d[top + 1] * la + b * d[top] / a);
+			break;
+		}
+		default: apply(in.op, v[top], d[top], v[top], d[top]); break;
+		}
+	}
+	f = v[0];
+	df = d[0];
+}
+
+void Expression::evaluate(const double *zx, const double *zy, double *fx, double *fy, double *dfx, double *dfy) const
+{
+	// Compiled code if there is any
+	if (native_ != nullptr) {
+		native_(zx, zy, fx, fy, dfx, dfy);
+		return;
+	}
+
+	// Stack of nf::FLN lanes per value, real and imaginary parts apart
+	const int L = nf::FLN;
+	double vr[nf::EXS][nf::FLN], vi[nf::EXS][nf::FLN], dr[nf::EXS][nf::FLN], di[nf::EXS][nf::FLN];
+	int top = -1;
+	for (const Instruction &in : code_) {
+		switch (in.op) {
+		case OP_Z:
+			++top;
+			for (int l = 0; l < L; ++l) {
+				vr[top][l] = zx[l];
+				vi[top][l] = zy[l];
+				dr[top][l] = 1;
+				di[top][l] = 0;
+			}
+			break;
+		case OP_CONST: {
+			++top;
+			const complex c = constants_[in.arg];
+			for (int l = 0; l < L; ++l) {
+				vr[top][l] = c.real();
+				vi[top][l] = c.imag();
+				dr[top][l] = 0;
+				di[top][l] = 0;
+			}
+			break;
+		}
+		case OP_ADD:
+			--top;
+			for (int l = 0; l < L; ++l) {
+				vr[top][l] += vr[top + 1][l];
+				vi[top][l] += vi[top + 1][l];
+				dr[top][l] += dr[top + 1][l];
+				di[top][l] += di[top + 1][l];
+			}
+			break;
+		case OP_SUB:
+			--top;
+			for (int l = 0; l < L; ++l) {
+				vr[top][l] -= vr[top + 1][l];
+				vi[top][l] -= vi[top + 1][l];
+				dr[top][l] -= dr[top + 1][l];
+				di[top][l] -= di[top + 1][l];
+			}
+			break;
+		case OP_MUL:
+			--top;
+			for (int l = 0; l < L; ++l) {
+				const double ar = vr[top][l], ai = vi[top][l], br = vr[top + 1][l], bi = vi[top + 1][l];
+				const double cr = dr[top][l], ci = di[top][l], er = dr[top + 1][l], ei = di[top + 1][l];
+				vr[top][l] = ar * br - ai * bi;
+				vi[top][l] = ar * bi + ai * br;
+				dr[top][l] = cr * br - ci * bi + ar * er - ai * ei;
+				di[top][l] = cr * bi + ci * br + ar * ei + ai * er;
+			}
+			break;
+		case OP_DIV:
+			--top;
+			for (int l = 0; l < L; ++l) {
+				const double ar = vr[top][l], ai = vi[top][l], br = vr[top + 1][l], bi = vi[top + 1][l];
+				const double den = br * br + bi * bi;
+				const double qr = (ar * br + ai * bi) / den, qi = (ai * br - ar * bi) / den;
+				const double tr = dr[top][l] - (qr * dr[top + 1][l] - qi * di[top + 1][l]);
+				const double ti = di[top][l] - (qr * di[top + 1][l] + qi * dr[top + 1][l]);
+				vr[top][l] = qr;
+				vi[top][l] = qi;
+				dr[top][l] = (tr * br + ti * bi) / den;
+				di[top][l] = (ti * br - tr * bi) / den;
+			}
+			break;
+		case OP_NEG:
+			for (int l = 0; l < L; ++l) {
+				vr[top][l] = -vr[top][l];
+				vi[top][l] = -vi[top][l];
+				dr[top][l] = -dr[top][l];
+				di[top][l] = -di[top][l];
+			}
+			break;
+		case OP_POWI:
+			for (int l = 0; l < L; ++l) {
+				complex v, d;
+				powi(complex(vr[top][l], vi[top][l]), complex(dr[top][l], di[top][l]), in.arg, v, d);
+				vr[top][l] = v.real();
+				vi[top][l] = v.imag();
+				dr[top][l] = d.real();
+				di[top][l] = d.imag();
+			}
+			break;
+		case OP_POW:
+			--top;
+			for (int l = 0; l < L; ++l) {
+				const complex a(vr[top][l], vi[top][l]), b(vr[top + 1][l], vi[top + 1][l]);
+				const complex la = std::log(a), v = std::exp(b * la);
+				const complex d = v * (complex(dr[top + 1][l], di[top + 1][l]) * la + b * complex(dr[top][l], di[top][l]) / a);
+				vr[top][l] = v.real();
+				vi[top][l] = v.imag();
+				dr[top][l] = d.real();
+				di[top][l] = d.imag();
+			}
+			break;
+		default:
+			for (int l = 0; l < L; ++l) {
+				complex v, d;
+				apply(in.op, complex(vr[top][l], vi[top][l]), complex(dr[top][l], di[top][l]), v, d);
+				vr[top][l] = v.real();
+				vi[top][l] = v.imag();
+				dr[top][l] = d.real();
+				di[top][l] = d.imag();
+			}
+			break;
+		}
+	}
+	for (int l = 0; l < L; ++l) {
+		fx[l] = vr[0][l];
+		fy[l] = vi[0][l];
+		dfx[l] = dr[0][l];
+		dfy[l] = di[0][l];
+	}
+}
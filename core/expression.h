@@ -0,0 +1,74 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "defaults.h"
+#include <QString>
+#include <QVector>
+
+// User defined f(z) compiled to bytecode for a stack machine. Every value on
+// the stack carries its derivative along (forward mode differentiation), so
+// f' needs no second expression. The grammar knows + - * / ^, implicit
+// multiplication, z, i, pi, e, numbers and the functions exp, log, sqrt, sin,
+// cos, tan, sinh, cosh and tanh. Integer powers compile to repeated squaring.
+//
+// The batch interpreter runs every instruction over nf::FLN points before
+// the next one, so decoding costs once per batch and the arithmetic loops
+// over the lanes vectorize. source() writes the same function as C++, which
+// KernelCache compiles to native code and hands back through setNative().
+
+enum OpCode : quint8 {
+	OP_Z,
+	OP_CONST,
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_NEG,
+	OP_POWI,
+	OP_POW,
+	OP_EXP,
+	OP_LOG,
+	OP_SQRT,
+	OP_SIN,
+	OP_COS,
+	OP_TAN,
+	OP_SINH,
+	OP_COSH,
+	OP_TANH
+};
+
+// Batch evaluation of nf::FLN lanes, the signature of compiled functions
+typedef void (*NativeFunction)(const double *zx, const double *zy, double *fx, double *fy, double *dfx, double *dfy);
+
+struct Instruction {
+	OpCode op;
+	int arg;	// Constant index or integer exponent
+};
+
+class Expression
+{
+public:
+	Expression();
+	static Expression compile(const QString &text, QString *error = nullptr);
+	bool isEmpty() const;
+	QString text() const;
+	int size() const;
+	QString source() const;
+	bool isNative() const;
+	void setNative(NativeFunction native);
+	void evaluate(complex z, complex &f, complex &df) const;
+	void evaluate(const double *zx, const double *zy, double *fx, double *fy, double *dfx, double *dfy) const;
+
+private:
+	QString text_;
+	QVector<Instruction> code_;
+	QVector<complex> constants_;
+	NativeFunction native_;
+};
+
+#endif // EXPRESSION_H
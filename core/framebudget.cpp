@@ -0,0 +1,60 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "framebudget.h"
+#include <QtMath>
+
+FrameBudget::FrameBudget() :
+	pixelMs_(0),
+	scale_(0),
+	iterations_(1)
+{
+}
+
+void FrameBudget::reset()
+{
+	// Forget all measurements
+	pixelMs_ = 0;
+	scale_ = 0;
+	iterations_ = 1;
+}
+
+void FrameBudget::record(const Parameters &params, double ms, int pixels, quint16 iterations)
+{
+	// Time per pixel as if the frame had run to max. iterations
+	if (pixels <= 0 || params.maxIterations == 0) return;
+	const double fraction = qBound(1e-3, double(iterations) / params.maxIterations, 1.0);
+	const double sample = ms / (pixels * fraction);
+
+	// Slower frames count at once, faster ones are smoothed
+	pixelMs_ = pixelMs_ <= 0 || sample > pixelMs_ ? sample : (1 - nf::SMO) * pixelMs_ + nf::SMO * sample;
+	scale_ = qSqrt(double(pixels) / qMax(1, params.size.width() * params.size.height()));
+	iterations_ = fraction;
+}
+
+double FrameBudget::scale(const Parameters &params) const
+{
+	// Fixed factor without budget or measurements
+	if (params.frameBudget <= 0 || pixelMs_ <= 0) return params.scaleDownFactor;
+	double scale = qSqrt(params.frameBudget / qMax(1e-9, estimate(params)));
+	if (scale_ > 0) scale = qMin(scale, scale_ * nf::SCG);
+	return qBound(nf::MSC, scale, 1.0);
+}
+
+quint16 FrameBudget::iterations(const Parameters &params) const
+{
+	// Cap iterations only if the smallest scale is still over budget
+	if (!params.capIterations || params.frameBudget <= 0 || pixelMs_ <= 0) return params.maxIterations;
+	double fraction = params.frameBudget / qMax(1e-9, estimate(params) * nf::MSC * nf::MSC);
+	fraction = qMin(fraction, iterations_ * nf::SCG);
+	if (fraction >= 1) return params.maxIterations;
+	return qMax<int>(qMin<int>(nf::MIC, params.maxIterations), qRound(fraction * params.maxIterations));
+}
+
+double FrameBudget::estimate(const Parameters &params) const
+{
+	// Milliseconds of a full size frame at max. iterations
+	return pixelMs_ * params.size.width() * params.size.height();
+}
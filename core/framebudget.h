@@ -0,0 +1,34 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef FRAMEBUDGET_H
+#define FRAMEBUDGET_H
+
+#include "parameters.h"
+
+// Picks the scale of interactive frames to render them within a frame time
+// budget. Render time grows with pixels times iterations, so every finished
+// frame gives an estimate of the time per pixel at max. iterations. The next
+// scale fits the full size frame into the budget with that estimate. It drops
+// at once but grows by at most nf::SCG per frame to avoid oscillating. Below
+// nf::MSC the iteration cap takes over if enabled.
+
+class FrameBudget
+{
+public:
+	FrameBudget();
+	void reset();
+	void record(const Parameters &params, double ms, int pixels, quint16 iterations);
+	double scale(const Parameters &params) const;
+	quint16 iterations(const Parameters &params) const;
+	double estimate(const Parameters &params) const;
+
+private:
+	double pixelMs_;		// Smoothed ms per pixel at max. iterations, 0 if unknown
+	double scale_;			// Scale of the last frame
+	double iterations_;		// Iteration cap of the last frame relative to max. iterations
+};
+
+#endif // FRAMEBUDGET_H
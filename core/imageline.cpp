@@ -0,0 +1,91 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "imageline.h"
+
+ImageLine::ImageLine() :
+	stats(nullptr),
+	reference(nullptr),
+	pixels(nullptr),
+	symmetry(nullptr),
+	orbits(nullptr),
+	resume(false),
+	equalizer(nullptr),
+	expression(nullptr),
+	converged(nullptr),
+	rootTable(nullptr)
+{
+}
+
+ImageLine::ImageLine(QRgb *scanLine, int lineIndex, int lineSize, const Parameters *params) :
+	scanLine(scanLine),
+	lineIndex(lineIndex),
+	lineSize(lineSize),
+	begin(0),
+	end(lineSize),
+	zx(0),
+	zy(0),
+	zyLo(0),
+	params(params),
+	stats(nullptr),
+	reference(nullptr),
+	pixels(nullptr),
+	symmetry(nullptr),
+	orbits(nullptr),
+	resume(false),
+	equalizer(nullptr),
+	expression(nullptr),
+	converged(nullptr),
+	rootTable(nullptr)
+{
+}
+
+ImageLine::ImageLine(const ImageLine &other) :
+	scanLine(other.scanLine),
+	lineIndex(other.lineIndex),
+	lineSize(other.lineSize),
+	begin(other.begin),
+	end(other.end),
+	zx(other.zx),
+	zy(other.zy),
+	zyLo(other.zyLo),
+	params(other.params),
+	stats(other.stats),
+	reference(other.reference),
+	pixels(other.pixels),
+	symmetry(other.symmetry),
+	orbits(other.orbits),
+	resume(other.resume),
+	equalizer(other.equalizer),
+	expression(other.expression),
+	converged(other.converged),
+	rootTable(other.rootTable)
+{
+}
+
+ImageLine &ImageLine::operator=(const ImageLine &other)
+{
+	// Assign other values to this
+	scanLine = other.scanLine;
+	lineIndex = other.lineIndex;
+	lineSize = other.lineSize;
+	begin = other.begin;
+	end = other.end;
+	zx = other.zx;
+	zy = other.zy;
+	zyLo = other.zyLo;
+	params = other.params;
+	stats = other.stats;
+	reference = other.reference;
+	pixels = other.pixels;
+	symmetry = other.symmetry;
+	orbits = other.orbits;
+	resume = other.resume;
+	equalizer = other.equalizer;
+	expression = other.expression;
+	converged = other.converged;
+	rootTable = other.rootTable;
+	return *this;
+}
@@ -0,0 +1,58 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef IMAGELINE_H
+#define IMAGELINE_H
+
+#include "parameters.h"
+#include "renderstats.h"
+#include <QRgb>
+
+struct ReferenceOrbit;
+class Symmetry;
+class Equalizer;
+class Expression;
+class RootTable;
+
+// Packed into 4 bytes, the frame keeps one per pixel. Up to nf::MRC roots
+// and 65535 iterations, the share of the last iteration in 32nds is finer
+// than the shades smooth coloring can tell apart.
+struct Pixel {
+	qint32 root : 11;			// -1 if not converged
+	quint32 share : 5;			// Share of the last iteration needed to converge, 31 is all of it
+	quint32 iteration : 16;
+	quint8 fraction() const { return quint8(share * 255 / 31); }
+	void setFraction(quint8 value) { share = (value * 31 + 127) / 255; }
+};
+Q_STATIC_ASSERT(sizeof(Pixel) == 4);
+Q_STATIC_ASSERT(nf::MRC < 1024);
+
+struct ImageLine {
+	ImageLine();
+	ImageLine(QRgb *scanLine, int lineIndex, int lineSize, const Parameters *params);
+	ImageLine(const ImageLine &other);
+	ImageLine &operator=(const ImageLine &other);
+	QRgb *scanLine; // <- points to pixel begin
+	int lineIndex;
+	int lineSize;
+	int begin;
+	int end;
+	double zx;
+	double zy;
+	double zyLo; // <- low part of zy for the double-double kernel
+	const Parameters *params;
+	LineStats *stats;
+	const ReferenceOrbit *reference; // <- set for perturbation rendering
+	Pixel *pixels; // <- root and iteration per pixel, may be null
+	const Symmetry *symmetry; // <- skip pixels the symmetry fills in
+	complex *orbits; // <- last z of unconverged pixels, may be null
+	bool resume; // <- only continue unconverged pixels from orbits
+	const Equalizer *equalizer; // <- equalised colors, fixed shading if null
+	const Expression *expression; // <- custom f(z) instead of the roots, may be null
+	complex *converged; // <- where pixels of a custom f(z) converged to, NaN if not
+	const RootTable *rootTable; // <- set for more than nf::SRC roots
+};
+
+#endif // IMAGELINE_H
@@ -0,0 +1,152 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "kernelcache.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QLibrary>
+#include <QProcess>
+#include <QFile>
+#include <QDir>
+
+#if defined(Q_OS_WIN)
+static const char *librarySuffix = ".dll";
+#elif defined(Q_OS_MACOS)
+static const char *librarySuffix = ".dylib";
+#else
+static const char *librarySuffix = ".so";
+#endif
+
+KernelCache &KernelCache::instance()
+{
+	// Process wide cache
+	static KernelCache cache;
+	return cache;
+}
+
+KernelCache::KernelCache() :
+	flags_({"-std=c++11", "-O3", "-march=native", "-fno-math-errno", "-fPIC", "-shared"}),
+	directory_(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/kernels")
+{
+	// First compiler found wins
+	QStringList candidates;
+	for (const char *variable : {"NF_CXX", "CXX"}) {
+		const QString value = QString::fromLocal8Bit(qgetenv(variable)).trimmed();
+		if (!value.isEmpty()) candidates.append(value);
+	}
+	candidates << "c++" << "g++" << "clang++";
+	for (const QString &candidate : candidates) {
+		compiler_ = QFileInfo(candidate).isAbsolute() ? candidate : QStandardPaths::findExecutable(candidate);
+		if (!compiler_.isEmpty() && QFileInfo(compiler_).isExecutable()) break;
+		compiler_.clear();
+	}
+	if (compiler_.isEmpty()) error_ = "no C++ compiler found";
+}
+
+bool KernelCache::isAvailable() const
+{
+	// A compiler was found
+	return !compiler_.isEmpty();
+}
+
+QString KernelCache::compiler() const
+{
+	// Path of the compiler
+	return compiler_;
+}
+
+QString KernelCache::error()
+{
+	// Reason of the last failure
+	QMutexLocker locker(&mutex_);
+	return error_;
+}
+
+NativeFunction KernelCache::find(const Expression &expression)
+{
+	// Loaded before or on disk, never compiles
+	if (expression.isEmpty() || !isAvailable()) return nullptr;
+	const QByteArray key = this->key(expression.source());
+	{
+		QMutexLocker locker(&mutex_);
+		if (functions_.contains(key)) return functions_.value(key);
+	}
+	if (!QFile::exists(path(key, librarySuffix))) return nullptr;
+	return load(key);
+}
+
+NativeFunction KernelCache::compile(const Expression &expression)
+{
+	// Blocks until the compiler is done, call it off the renderer's thread
+	if (expression.isEmpty() || !isAvailable()) return nullptr;
+	const QString source = expression.source();
+	const QByteArray key = this->key(source);
+	{
+		QMutexLocker locker(&mutex_);
+		if (functions_.contains(key)) return functions_.value(key);
+	}
+	const QString target = path(key, librarySuffix);
+	if (QFile::exists(target)) return load(key);
+
+	// Keep the source next to the library
+	QDir().mkpath(directory_);
+	QFile file(path(key, ".cpp"));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return fail(key, "cannot write " + file.fileName());
+	file.write(source.toUtf8());
+	file.close();
+
+	// Compile to a name of this process and move it in place afterwards, so
+	// no process loads a library that is only half written
+	const QString temporary = target + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+	QProcess process;
+	process.setProcessChannelMode(QProcess::MergedChannels);
+	process.start(compiler_, QStringList(flags_) << "-o" << temporary << file.fileName());
+	const bool finished = process.waitForFinished(nf::KCT);
+	if (!finished || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+		if (!finished) process.kill();
+		QFile::remove(temporary);
+		const QString output = QString::fromLocal8Bit(process.readAllStandardOutput()).trimmed();
+		return fail(key, output.isEmpty() ? "compiler did not finish" : output);
+	}
+	if (!QFile::rename(temporary, target)) QFile::remove(temporary);
+	return load(key);
+}
+
+QByteArray KernelCache::key(const QString &source) const
+{
+	// Same source with the same compiler and flags gives the same library
+	const QString text = compiler_ + '\n' + flags_.join(' ') + '\n' + source;
+	return QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1).toHex();
+}
+
+QString KernelCache::path(const QByteArray &key, const QString &suffix) const
+{
+	// File of a kernel in the cache directory
+	return directory_ + "/nf_" + QString::fromLatin1(key) + suffix;
+}
+
+NativeFunction KernelCache::load(const QByteArray &key)
+{
+	// Libraries stay loaded until the process ends
+	QLibrary library(path(key, librarySuffix));
+	if (!library.load()) return fail(key, library.errorString());
+	NativeFunction native = reinterpret_cast<NativeFunction>(library.resolve("nf_function"));
+	if (native == nullptr) return fail(key, library.errorString());
+	QMutexLocker locker(&mutex_);
+	functions_.insert(key, native);
+	return native;
+}
+
+NativeFunction KernelCache::fail(const QByteArray &key, const QString &error)
+{
+	// Do not try the same kernel again
+	QMutexLocker locker(&mutex_);
+	functions_.insert(key, nullptr);
+	error_ = error;
+	return nullptr;
+}
@@ -0,0 +1,48 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef KERNELCACHE_H
+#define KERNELCACHE_H
+
+#include "expression.h"
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+// Compiles custom functions to native code with the C++ compiler of the
+// system ($NF_CXX, $CXX, c++, g++ or clang++) and loads them as shared
+// libraries. Libraries are kept in the cache directory under the hash of
+// their source and compiler, so a function compiles once per machine.
+// Without a compiler, or if it fails, expressions stay interpreted.
+
+class KernelCache
+{
+public:
+	static KernelCache &instance();
+	bool isAvailable() const;
+	QString compiler() const;
+	QString error();
+	NativeFunction find(const Expression &expression);
+	NativeFunction compile(const Expression &expression);
+
+protected:
+	KernelCache();
+	QByteArray key(const QString &source) const;
+	QString path(const QByteArray &key, const QString &suffix) const;
+	NativeFunction load(const QByteArray &key);
+	NativeFunction fail(const QByteArray &key, const QString &error);
+
+private:
+	QMutex mutex_;
+	QString compiler_;
+	QStringList flags_;
+	QString directory_;
+	QHash<QByteArray, NativeFunction> functions_;	// nullptr once a kernel failed
+	QString error_;
+};
+
+#endif // KERNELCACHE_H
@@ -0,0 +1,249 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "limits.h"
+#include "defaults.h"
+
+Limits::Limits() :
+	left_(-1.0),
+	right_(1.0),
+	top_(1.0),
+	bottom_(-1.0),
+	originalLeft_(-1.0),
+	originalRight_(1.0),
+	originalTop_(1.0),
+	originalBottom_(-1.0)
+{
+}
+
+bool Limits::operator==(const Limits &other) const
+{
+	// Check if limits are the same
+	return (
+		left_ == other.left_ &&
+		right_ == other.right_ &&
+		top_ == other.top_ &&
+		bottom_ == other.bottom_
+	);
+}
+
+bool Limits::operator!=(const Limits &other) const
+{
+	// Check if limits are not the same
+	return (
+		left_ != other.left_ ||
+		right_ != other.right_ ||
+		top_ != other.top_ ||
+		bottom_ != other.bottom_
+	);
+}
+
+void Limits::move(QPoint distance, const QSize &ref)
+{
+	// Move limits by distance, in double-double so deep views don't drift
+	ddouble dx = (right_ - left_) * double(distance.x()) / ddouble(ref.width() - 1);
+	ddouble dy = (bottom_ - top_) * double(distance.y()) / ddouble(ref.height() - 1);
+	left_ += dx;
+	right_ += dx;
+	top_ += dy;
+	bottom_ += dy;
+
+	// Move original limits
+	ddouble odx = (originalRight_ - originalLeft_) * double(distance.x()) / ddouble(ref.width() - 1);
+	ddouble ody = (originalBottom_ - originalTop_) * double(distance.y()) / ddouble(ref.height() - 1);
+	originalLeft_ += odx;
+	originalRight_ += odx;
+	originalTop_ += ody;
+	originalBottom_ += ody;
+}
+
+void Limits::zoom(bool in, double xw, double yw)
+{
+	// Zoom limits in / out
+	double zoom = in ? -nf::ZMF : nf::ZMF;
+	ddouble wZoom = (right_ - left_) * zoom;
+	ddouble hZoom = (top_ - bottom_) * zoom;
+	left_ -= wZoom * xw;
+	right_ += wZoom * (1.0 - xw);
+	top_ += hZoom * yw;
+	bottom_ -= hZoom * (1.0 - yw);
+}
+
+void Limits::reset(QSize size)
+{
+	// Reset limits to match size
+	left_ = -nf::DSF * size.width();
+	right_ = nf::DSF * size.width();
+	top_ = nf::DSF * size.height();
+	bottom_ = -nf::DSF * size.height();
+
+	// Reset original limits
+	originalLeft_ = left_;
+	originalRight_ = right_;
+	originalTop_ = top_;
+	originalBottom_ = bottom_;
+}
+
+void Limits::resize(QSize delta)
+{
+	// Resize limits
+	right_ += ddouble(nf::DSF * delta.width());
+	left_ -= ddouble(nf::DSF * delta.width());
+	top_ += ddouble(nf::DSF * delta.height());
+	bottom_ -= ddouble(nf::DSF * delta.height());
+
+	// Resize original limits
+	originalRight_ += ddouble(nf::DSF * delta.width());
+	originalLeft_ -= ddouble(nf::DSF * delta.width());
+	originalTop_ += ddouble(nf::DSF * delta.height());
+	originalBottom_ -= ddouble(nf::DSF * delta.height());
+}
+
+void Limits::set(double left, double right, double top, double bottom)
+{
+	// Set limits
+	left_ = left;
+	right_ = right;
+	top_ = top;
+	bottom_ = bottom;
+}
+
+void Limits::set(ddouble left, ddouble right, ddouble top, ddouble bottom)
+{
+	// Set limits with extra precision
+	left_ = left;
+	right_ = right;
+	top_ = top;
+	bottom_ = bottom;
+}
+
+void Limits::setOriginal(double left, double right, double top, double bottom)
+{
+	// Set original limits
+	originalLeft_ = left;
+	originalRight_ = right;
+	originalTop_ = top;
+	originalBottom_ = bottom;
+}
+
+double Limits::width() const
+{
+	// Return width
+	return (right_ - left_).hi;
+}
+
+double Limits::height() const
+{
+	// Return height
+	return (top_ - bottom_).hi;
+}
+
+double Limits::left() const
+{
+	// Return left limit
+	return left_.hi;
+}
+
+double Limits::right() const
+{
+	// Return right limit
+	return right_.hi;
+}
+
+double Limits::top() const
+{
+	// Return top limit
+	return top_.hi;
+}
+
+double Limits::bottom() const
+{
+	// Return bottom limit
+	return bottom_.hi;
+}
+
+ddouble Limits::widthDD() const
+{
+	// Return width with extra precision
+	return right_ - left_;
+}
+
+ddouble Limits::heightDD() const
+{
+	// Return height with extra precision
+	return top_ - bottom_;
+}
+
+ddouble Limits::leftDD() const
+{
+	// Return left limit with extra precision
+	return left_;
+}
+
+ddouble Limits::rightDD() const
+{
+	// Return right limit with extra precision
+	return right_;
+}
+
+ddouble Limits::topDD() const
+{
+	// Return top limit with extra precision
+	return top_;
+}
+
+ddouble Limits::bottomDD() const
+{
+	// Return bottom limit with extra precision
+	return bottom_;
+}
+
+ddcomplex Limits::centerDD() const
+{
+	// Return center with extra precision
+	return ddcomplex((left_ + right_) * 0.5, (top_ + bottom_) * 0.5);
+}
+
+bool Limits::exceedsDouble(int pixels) const
+{
+	// Check if pixel spacing relative to the coordinates is below double resolution
+	double magnitude = qMax(qMax(qAbs(left_.hi), qAbs(right_.hi)), qMax(qAbs(top_.hi), qAbs(bottom_.hi)));
+	double spacing = qMin(width(), height()) / qMax(1, pixels - 1);
+	return spacing < nf::DDT * magnitude;
+}
+
+QVector4D Limits::vec4() const
+{
+	// Return limits as vec4
+	return QVector4D(top_.hi, right_.hi, bottom_.hi, left_.hi);
+}
+
+double Limits::zoomFactor() const
+{
+	// Return zoomFactor
+	return (originalRight_ - originalLeft_).hi / width();
+}
+
+void Limits::setZoomFactor(double zoomFactor)
+{
+	// Set zoomFactor
+	double w2 = 0.5 * (originalRight_ - originalLeft_).hi / zoomFactor;
+	double h2 = 0.5 * (originalTop_ - originalBottom_).hi / zoomFactor;
+	ddouble xMid = right_ * 0.5 + left_ * 0.5;
+	ddouble yMid = top_ * 0.5 + bottom_ * 0.5;
+	right_ = xMid + w2;
+	left_ = xMid - w2;
+	top_ = yMid + h2;
+	bottom_ = yMid - h2;
+}
+
+Limits Limits::original() const
+{
+	// Return original limits
+	Limits limits;
+	limits.set(originalLeft_, originalRight_, originalTop_, originalBottom_);
+	limits.setOriginal(originalLeft_.hi, originalRight_.hi, originalTop_.hi, originalBottom_.hi);
+	return limits;
+}
@@ -6,6 +6,7 @@
 #ifndef LIMITS_H
 #define LIMITS_H
 
+#include "doubledouble.h"
 #include <QSize>
 #include <QPoint>
 #include <QVector4D>
@@ -13,9 +14,7 @@
 class Limits
 {
 public:
-	Limits(bool original = false);
-	~Limits();
-	Limits &operator=(const Limits &other);
+	Limits();
 	bool operator==(const Limits &other) const;
 	bool operator!=(const Limits &other) const;
 	void move(QPoint distance, const QSize &ref);
@@ -23,6 +22,7 @@ public:
 	void reset(QSize size);
 	void resize(QSize delta);
 	void set(double left, double right, double top, double bottom);
+	void set(ddouble left, ddouble right, ddouble top, ddouble bottom);
 	void setOriginal(double left, double right, double top, double bottom);
 
 	double width() const;
@@ -31,17 +31,28 @@ public:
 	double right() const;
 	double top() const;
 	double bottom() const;
+	ddouble widthDD() const;
+	ddouble heightDD() const;
+	ddouble leftDD() const;
+	ddouble rightDD() const;
+	ddouble topDD() const;
+	ddouble bottomDD() const;
+	ddcomplex centerDD() const;
+	bool exceedsDouble(int pixels) const;
 	QVector4D vec4() const;
 	double zoomFactor() const;
 	void setZoomFactor(double zoomFactor);
-	const Limits *original() const;
+	Limits original() const;
 
 private:
-	double left_;
-	double right_;
-	double top_;
-	double bottom_;
-	Limits *original_;
+	ddouble left_;
+	ddouble right_;
+	ddouble top_;
+	ddouble bottom_;
+	ddouble originalLeft_;		// Limits at zoom factor 1, kept inline
+	ddouble originalRight_;		// so copies do not allocate
+	ddouble originalTop_;
+	ddouble originalBottom_;
 };
 
 #endif // LIMITS_H
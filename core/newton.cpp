@@ -0,0 +1,483 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "newton.h"
+#include "perturbation.h"
+#include "symmetry.h"
+#include "tracer.h"
+#include <QVarLengthArray>
+#include <QtNumeric>
+#include <algorithm>
+
+void iterateZF(const float *zx, const float *zy, int count, const Parameters &params, int *root, quint16 *iterations, quint8 *fractions)
+{
+	// Roots and damping in single precision, precision() only picks float
+	// for up to nf::SRC roots
+	const int rootCount = params.roots.count();
+	Q_ASSERT(rootCount <= nf::SRC);
+	float rx[nf::SRC], ry[nf::SRC];
+	float radius = 0;
+	for (int k = 0; k < rootCount; ++k) {
+		rx[k] = float(params.roots[k].value().real());
+		ry[k] = float(params.roots[k].value().imag());
+		radius = qMax(radius, float(abs(params.roots[k].value())));
+	}
+	const float dr = float(params.damping.real());
+	const float di = float(params.damping.imag());
+	const float eps2 = float(nf::EPS * nf::EPS);
+
+	// Beyond zMax the products of f and f' could overflow, escalate those lanes
+	const float zMax = qMax(0.0f, std::pow(1e17f, 1.0f / qMax(1, rootCount)) - radius);
+	const float zMax2 = zMax * zMax;
+
+	// Initialize lanes, unused lanes repeat the first point
+	float x[nf::FLN], y[nf::FLN], previous[nf::FLN];
+	bool active[nf::FLN];
+	int remaining = count;
+	for (int l = 0; l < nf::FLN; ++l) {
+		x[l] = zx[l < count ? l : 0];
+		y[l] = zy[l < count ? l : 0];
+		previous[l] = 0;
+		active[l] = l < count;
+		if (l < count) {
+			root[l] = rootCount < 2 ? -2 : -1;
+			iterations[l] = params.maxIterations;
+			fractions[l] = 255;
+		}
+	}
+	if (rootCount < 2) return;
+
+	// Newton iteration, the lane loops are free of branches so they vectorize
+	for (quint16 i = 0; i < params.maxIterations && remaining > 0; ++i) {
+		float rr[nf::FLN], ri[nf::FLN], lr[nf::FLN], li[nf::FLN], step[nf::FLN];
+		for (int l = 0; l < nf::FLN; ++l) {
+			rr[l] = x[l] - rx[0];
+			ri[l] = y[l] - ry[0];
+			lr[l] = x[l] - rx[1];
+			li[l] = y[l] - ry[1];
+		}
+		for (int k = 1; k < rootCount - 1; ++k) {
+			for (int l = 0; l < nf::FLN; ++l) {
+				const float sr = lr[l] + rr[l], si = li[l] + ri[l];
+				const float ar = x[l] - rx[k + 1], ai = y[l] - ry[k + 1];
+				const float br = x[l] - rx[k], bi = y[l] - ry[k];
+				lr[l] = ar * sr - ai * si;
+				li[l] = ar * si + ai * sr;
+				const float tr = rr[l] * br - ri[l] * bi;
+				ri[l] = rr[l] * bi + ri[l] * br;
+				rr[l] = tr;
+			}
+		}
+		for (int l = 0; l < nf::FLN; ++l) {
+			const float dfr = lr[l] + rr[l], dfi = li[l] + ri[l];
+			const float cr = x[l] - rx[rootCount - 1], ci = y[l] - ry[rootCount - 1];
+			const float fr = rr[l] * cr - ri[l] * ci, fi = rr[l] * ci + ri[l] * cr;
+			const float den = dfr * dfr + dfi * dfi;
+			const float qr = (fr * dfr + fi * dfi) / den, qi = (fi * dfr - fr * dfi) / den;
+			const float sr = dr * qr - di * qi, si = dr * qi + di * qr;
+			x[l] -= sr;
+			y[l] -= si;
+			step[l] = sr * sr + si * si;
+		}
+
+		// Converged or escaped lanes are done
+		for (int l = 0; l < count; ++l) {
+			if (!active[l]) continue;
+			if (!(x[l] * x[l] + y[l] * y[l] < zMax2)) {
+				root[l] = -2;
+				active[l] = false;
+				remaining--;
+			} else if (step[l] < eps2) {
+				for (int k = 0; k < rootCount; ++k) {
+					const float ex = x[l] - rx[k], ey = y[l] - ry[k];
+					if (ex * ex + ey * ey < eps2) {
+						root[l] = k;
+						iterations[l] = i;
+						fractions[l] = stepFraction(previous[l], step[l]);
+						active[l] = false;
+						remaining--;
+						break;
+					}
+				}
+			}
+		}
+		for (int l = 0; l < nf::FLN; ++l) previous[l] = step[l];
+	}
+}
+
+void iterateZE(const double *zx, const double *zy, int count, const Parameters &params, const Expression &expression,
+	complex *points, quint16 *iterations, quint8 *fractions)
+{
+	// Damping and tolerance
+	const double dr = params.damping.real();
+	const double di = params.damping.imag();
+	const double eps2 = nf::EPS * nf::EPS;
+
+	// Initialize lanes, unused lanes repeat the first point
+	double x[nf::FLN], y[nf::FLN], previous[nf::FLN];
+	bool active[nf::FLN];
+	int remaining = count;
+	for (int l = 0; l < nf::FLN; ++l) {
+		x[l] = zx[l < count ? l : 0];
+		y[l] = zy[l < count ? l : 0];
+		previous[l] = 0;
+		active[l] = l < count;
+		if (l < count) {
+			points[l] = complex(qQNaN(), qQNaN());
+			iterations[l] = params.maxIterations;
+			fractions[l] = 255;
+		}
+	}
+
+	// Newton iteration, the bytecode runs over all lanes at once
+	for (quint16 i = 0; i < params.maxIterations && remaining > 0; ++i) {
+		double fr[nf::FLN], fi[nf::FLN], dfr[nf::FLN], dfi[nf::FLN], step[nf::FLN];
+		expression.evaluate(x, y, fr, fi, dfr, dfi);
+		for (int l = 0; l < nf::FLN; ++l) {
+			const double den = dfr[l] * dfr[l] + dfi[l] * dfi[l];
+			const double qr = (fr[l] * dfr[l] + fi[l] * dfi[l]) / den, qi = (fi[l] * dfr[l] - fr[l] * dfi[l]) / den;
+			const double sr = dr * qr - di * qi, si = dr * qi + di * qr;
+			x[l] -= sr;
+			y[l] -= si;
+			step[l] = sr * sr + si * si;
+		}
+
+		// Lanes that stopped moving converged, escaped ones never will
+		for (int l = 0; l < count; ++l) {
+			if (!active[l]) continue;
+			if (!std::isfinite(x[l]) || !std::isfinite(y[l])) {
+				active[l] = false;
+				remaining--;
+			} else if (step[l] < eps2) {
+				points[l] = complex(x[l], y[l]);
+				iterations[l] = i;
+				fractions[l] = stepFraction(previous[l], step[l]);
+				active[l] = false;
+				remaining--;
+			}
+		}
+		for (int l = 0; l < nf::FLN; ++l) previous[l] = step[l];
+	}
+}
+
+void iterateZR(const double *zx, const double *zy, int count, const Parameters &params, const RootTable &table,
+	int *root, quint16 *iterations, quint8 *fractions, complex *last, const quint16 *first)
+{
+	// Damping and tolerance
+	const double dr = params.damping.real();
+	const double di = params.damping.imag();
+	const double eps2 = nf::EPS * nf::EPS;
+
+	// Initialize lanes, unused lanes repeat the first point. Resumed lanes
+	// continue at their own iteration, those already at the limit are done.
+	double x[nf::FLN], y[nf::FLN], previous[nf::FLN];
+	int start[nf::FLN];
+	bool active[nf::FLN];
+	int remaining = 0;
+	for (int l = 0; l < nf::FLN; ++l) {
+		x[l] = zx[l < count ? l : 0];
+		y[l] = zy[l < count ? l : 0];
+		previous[l] = 0;
+		start[l] = first != nullptr && l < count ? first[l] : 0;
+		active[l] = l < count && start[l] < params.maxIterations;
+		remaining += active[l];
+		if (l < count) {
+			root[l] = -1;
+			iterations[l] = qMax<int>(start[l], params.maxIterations);
+			fractions[l] = 255;
+		}
+	}
+
+	// Newton iteration, the table sums over the roots for all lanes at once
+	for (int s = 0; remaining > 0; ++s) {
+		double qr[nf::FLN], qi[nf::FLN], step[nf::FLN];
+		table.quotient(x, y, qr, qi);
+		for (int l = 0; l < nf::FLN; ++l) {
+			const double sr = dr * qr[l] - di * qi[l], si = dr * qi[l] + di * qr[l];
+			x[l] = active[l] ? x[l] - sr : x[l];
+			y[l] = active[l] ? y[l] - si : y[l];
+			step[l] = sr * sr + si * si;
+		}
+
+		// Small steps near a root converged, the grid finds which one
+		for (int l = 0; l < count; ++l) {
+			if (!active[l]) continue;
+			const int i = start[l] + s;
+			const int r = step[l] < eps2 ? table.find(x[l], y[l]) : -1;
+			if (r >= 0) {
+				root[l] = r;
+				iterations[l] = i;
+				fractions[l] = stepFraction(previous[l], step[l]);
+			}
+			if (r >= 0 || !std::isfinite(x[l]) || !std::isfinite(y[l]) || i + 1 >= params.maxIterations) {
+				active[l] = false;
+				remaining--;
+			}
+		}
+		for (int l = 0; l < nf::FLN; ++l) previous[l] = step[l];
+	}
+
+	// Orbits that did not converge may be resumed
+	for (int l = 0; l < count; ++l) {
+		if (root[l] < 0) last[l] = complex(x[l], y[l]);
+	}
+}
+
+void iterateX(ImageLine &il)
+{
+	// Iterate x-pixels
+	NF_TRACE_SCOPE("line", "worker", il.lineIndex);
+	const double left = il.params->limits.left();
+	const double xFactor = il.params->limits.width() / (il.lineSize - 1);
+
+	// Float at shallow zooms, perturbation or double-double if pixels are
+	// closer than double can tell apart
+	const Precision precision = il.params->precision(il.lineSize);
+	const bool deep = precision == PRECISION_DOUBLE_DOUBLE || precision == PRECISION_PERTURBATION;
+	const ReferenceOrbit *ref = precision == PRECISION_PERTURBATION ? il.reference : nullptr;
+	const ddouble leftDD = il.params->limits.leftDD();
+	const ddouble xFactorDD = il.params->limits.widthDD() / ddouble(il.lineSize - 1);
+	const ddouble zyDD(il.zy, il.zyLo);
+	perfAttachThread();
+#ifndef NF_NO_STATS
+	const qint64 start = il.stats != nullptr ? statsClock() : 0;
+	quint64 iterations = 0;
+	int converged = 0;
+#endif
+
+	// Pixels to compute, the symmetry fills in the others afterwards.
+	// Resuming only continues pixels that did not converge yet.
+	const bool resume = il.resume && il.pixels != nullptr && il.orbits != nullptr;
+	QVarLengthArray<int, 1024> xs;
+	for (int x = il.begin; x < il.end; ++x) {
+		int turns;
+		bool mirrored;
+		if (resume && il.pixels[x - il.begin].root >= 0) continue;
+		if (il.symmetry == nullptr || il.symmetry->source(x, il.lineIndex, turns, mirrored) < 0) xs.append(x);
+	}
+	const int count = xs.size();
+
+	// Custom functions run in double lanes, their roots are assigned after the frame
+	const bool custom = il.expression != nullptr && il.converged != nullptr;
+	QVarLengthArray<complex, 1024> customPoints(custom ? count : 0);
+	QVarLengthArray<quint16, 1024> customIterations(customPoints.size());
+	QVarLengthArray<quint8, 1024> customFractions(customPoints.size());
+	for (int k = 0; k < customPoints.size(); k += nf::FLN) {
+		double zx[nf::FLN], zy[nf::FLN];
+		const int lanes = qMin<int>(nf::FLN, count - k);
+		for (int l = 0; l < lanes; ++l) {
+			zx[l] = xs[k + l] * xFactor + left;
+			zy[l] = il.zy;
+		}
+		iterateZE(zx, zy, lanes, *il.params, *il.expression,
+			customPoints.data() + k, customIterations.data() + k, customFractions.data() + k);
+	}
+
+	// Many roots run in double lanes over the root table, resumed pixels
+	// continue their orbits
+	const bool many = !custom && il.rootTable != nullptr && precision == PRECISION_DOUBLE;
+	QVarLengthArray<int, 1024> manyRoots(many ? count : 0);
+	QVarLengthArray<quint16, 1024> manyIterations(manyRoots.size());
+	QVarLengthArray<quint8, 1024> manyFractions(manyRoots.size());
+	QVarLengthArray<complex, 1024> manyLast(manyRoots.size());
+	for (int k = 0; k < manyRoots.size(); k += nf::FLN) {
+		double zx[nf::FLN], zy[nf::FLN];
+		quint16 first[nf::FLN];
+		const int lanes = qMin<int>(nf::FLN, count - k);
+		for (int l = 0; l < lanes; ++l) {
+			const int x = xs[k + l];
+			const complex z = resume ? il.orbits[x - il.begin] : complex(x * xFactor + left, il.zy);
+			zx[l] = z.real();
+			zy[l] = z.imag();
+			first[l] = resume ? il.pixels[x - il.begin].iteration : 0;
+		}
+		iterateZR(zx, zy, lanes, *il.params, *il.rootTable, manyRoots.data() + k,
+			manyIterations.data() + k, manyFractions.data() + k, manyLast.data() + k, first);
+	}
+
+	// Run the float kernel over the whole line first
+	QVarLengthArray<int, 1024> floatRoots(precision == PRECISION_FLOAT && !resume && !custom ? count : 0);
+	QVarLengthArray<quint16, 1024> floatIterations(floatRoots.size());
+	QVarLengthArray<quint8, 1024> floatFractions(floatRoots.size());
+	for (int k = 0; k < floatRoots.size(); k += nf::FLN) {
+		float zx[nf::FLN], zy[nf::FLN];
+		const int lanes = qMin<int>(nf::FLN, count - k);
+		for (int l = 0; l < lanes; ++l) {
+			zx[l] = float(xs[k + l] * xFactor + left);
+			zy[l] = float(il.zy);
+		}
+		iterateZF(zx, zy, lanes, *il.params, floatRoots.data() + k, floatIterations.data() + k, floatFractions.data() + k);
+	}
+
+	for (int k = 0; k < count; ++k) {
+
+		// Create complex number from current pixel
+		const int x = xs[k];
+		complex *orbit = il.orbits != nullptr ? il.orbits + (x - il.begin) : nullptr;
+		quint16 first = resume ? il.pixels[x - il.begin].iteration : 0;
+		quint16 i;
+		quint8 fraction = 255;
+		int r;
+		il.zx = x * xFactor + left;
+		if (custom) {
+			r = -1;
+			i = customIterations[k];
+			fraction = customFractions[k];
+			il.converged[x - il.begin] = customPoints[k];
+		} else if (many) {
+			r = manyRoots[k];
+			i = manyIterations[k];
+			fraction = manyFractions[k];
+			if (r < 0 && orbit != nullptr) *orbit = manyLast[k];
+		} else if (resume) {
+			r = iterateZ(*orbit, *il.params, i, first, orbit, &fraction, il.rootTable);
+		} else if (precision == PRECISION_FLOAT) {
+
+			// Escalate undecided pixels and basin boundaries to double
+			r = floatRoots[k];
+			i = floatIterations[k];
+			fraction = floatFractions[k];
+			bool boundary =
+				(k > 0 && xs[k - 1] == x - 1 && floatRoots[k - 1] != r) ||
+				(k + 1 < count && xs[k + 1] == x + 1 && floatRoots[k + 1] != r);
+			if (r < 0 || boundary) {
+				r = iterateZ(complex(il.zx, il.zy), *il.params, i, 0, orbit, &fraction, il.rootTable);
+			}
+		} else if (ref != nullptr) {
+			complex delta(
+				(leftDD + xFactorDD * double(x) - ref->center.re).hi,
+				(zyDD - ref->center.im).hi);
+			r = iterateDelta(delta, *ref, *il.params, i, &fraction);
+		} else if (deep) {
+			ddcomplex z(leftDD + xFactorDD * double(x), zyDD);
+			r = iterateZDD(z, *il.params, i, &fraction, il.rootTable);
+		} else {
+			complex z(il.zx, il.zy);
+			r = iterateZ(z, *il.params, i, 0, orbit, &fraction, il.rootTable);
+		}
+
+		// If root has been found set color, shaded from the stored fraction
+		// like the pixels the later passes fill
+		Pixel pixel;
+		pixel.root = r;
+		pixel.setFraction(fraction);
+		pixel.iteration = i;
+		if (r >= 0) {
+			il.scanLine[x - il.begin] = lineColor(il, r, i, pixel.fraction());
+		}
+		if (il.pixels != nullptr) il.pixels[x - il.begin] = pixel;
+#ifndef NF_NO_STATS
+		const bool found = r >= 0 || (custom && i < il.params->maxIterations);
+		iterations += (found ? i + 1 : i) - first;
+		converged += found;
+#endif
+	}
+
+#ifndef NF_NO_STATS
+	// Record line statistics
+	if (il.stats != nullptr) {
+		il.stats->line = il.lineIndex;
+		il.stats->thread = statsThreadIndex();
+		il.stats->start = start;
+		il.stats->end = statsClock();
+		il.stats->pixels = count;
+		il.stats->iterations = iterations;
+		il.stats->converged = converged;
+		il.stats->unconverged = il.stats->pixels - converged;
+	}
+#endif
+}
+
+void fillX(ImageLine &il, const Pixel *pixels)
+{
+	// Copy the turned or mirrored pixel and permute its root
+	NF_TRACE_SCOPE("fill", "worker", il.lineIndex);
+	if (il.symmetry == nullptr) return;
+	for (int x = il.begin; x < il.end; ++x) {
+		int turns;
+		bool mirrored;
+		int source = il.symmetry->source(x, il.lineIndex, turns, mirrored);
+		if (source < 0) continue;
+		Pixel pixel = pixels[source];
+		pixel.root = il.symmetry->permute(pixel.root, turns, mirrored);
+		il.scanLine[x - il.begin] = lineColor(il, pixel.root, pixel.iteration, pixel.fraction());
+		if (il.pixels != nullptr) il.pixels[x - il.begin] = pixel;
+	}
+}
+
+static bool isEdge(const Pixel &pixel, const Pixel &other)
+{
+	// Other root or a sharp step in iterations
+	return other.root != pixel.root || qAbs(int(other.iteration) - int(pixel.iteration)) > nf::AAI;
+}
+
+void antialiasX(ImageLine &il, const Pixel *pixels, int height)
+{
+	// Iterate the sample pattern only on basin boundaries
+	NF_TRACE_SCOPE("antialias", "worker", il.lineIndex);
+	const QVector<QPointF> pattern = samplePattern(il.params->antiAliasing);
+	if (pattern.isEmpty()) return;
+	const int width = il.lineSize;
+	const int y = il.lineIndex;
+	const double left = il.params->limits.left();
+	const double xFactor = il.params->limits.width() / (width - 1);
+	const double yFactor = -il.params->limits.height() / (height - 1);
+	const Pixel *line = pixels + y * width;
+	for (int x = il.begin; x < il.end; ++x) {
+		const Pixel &pixel = line[x];
+		bool edge =
+			(x > 0 && isEdge(pixel, line[x - 1])) ||
+			(x + 1 < width && isEdge(pixel, line[x + 1])) ||
+			(y > 0 && isEdge(pixel, line[x - width])) ||
+			(y + 1 < height && isEdge(pixel, line[x + width]));
+		if (!edge) {
+			il.scanLine[x - il.begin] = lineColor(il, pixel.root, pixel.iteration, pixel.fraction());
+			continue;
+		}
+
+		// Average the colors of all samples
+		int red = 0, green = 0, blue = 0;
+		for (const QPointF &offset : pattern) {
+			complex z((x + offset.x()) * xFactor + left, il.zy + offset.y() * yFactor);
+			quint16 i;
+			quint8 fraction = 255;
+			QRgb color = lineColor(il, iterateZ(z, *il.params, i, 0, nullptr, &fraction, il.rootTable), i, fraction);
+			red += qRed(color);
+			green += qGreen(color);
+			blue += qBlue(color);
+		}
+		const int n = pattern.size();
+		il.scanLine[x - il.begin] = qRgb(red / n, green / n, blue / n);
+	}
+}
+
+void renderTile(const Parameters &params, QSize size, QRect tile, QRgb *buffer, int stride)
+{
+	// Clip tile to image
+	tile = tile.intersected(QRect(QPoint(0, 0), size));
+	if (tile.isEmpty()) return;
+
+	// Reference orbit for deep zooms and root table of high degrees
+	ReferenceOrbit reference;
+	if (params.perturbation && params.limits.exceedsDouble(size.width()))
+		reference = ReferenceOrbit(params, params.limits.centerDD());
+	const RootTable table = params.roots.count() > nf::SRC ? RootTable(params.roots) : RootTable();
+
+	// Iterate y-pixels of tile
+	const ddouble yFactor = -params.limits.heightDD() / ddouble(size.height() - 1);
+	for (int y = tile.top(); y <= tile.bottom(); ++y) {
+		QRgb *scanLine = buffer + (y - tile.top()) * stride;
+		std::fill(scanLine, scanLine + tile.width(), qRgb(0, 0, 0));
+		ImageLine il(scanLine, y, size.width(), &params);
+		il.begin = tile.left();
+		il.end = tile.right() + 1;
+		ddouble zy = params.limits.topDD() + yFactor * double(y);
+		il.zy = zy.hi;
+		il.zyLo = zy.lo;
+		il.reference = reference.isEmpty() ? nullptr : &reference;
+		il.rootTable = table.isEmpty() ? nullptr : &table;
+		iterateX(il);
+	}
+}
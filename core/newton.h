@@ -0,0 +1,221 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef NEWTON_H
+#define NEWTON_H
+
+#include "parameters.h"
+#include "imageline.h"
+#include "doubledouble.h"
+#include "equalizer.h"
+#include "expression.h"
+#include "roottable.h"
+#include <QRect>
+#include <QRgb>
+#include <cmath>
+
+inline void func(complex z, complex &f, complex &df, const QVector<Root> &roots)
+{
+	// Calculate f and derivative with given roots
+	const int rootCount = roots.length();
+	if (rootCount < 2) return;
+
+	// TODO: algorithm documentation
+	complex r = (z - roots[0].value());
+	complex l = (z - roots[1].value());
+	for (int i = 1; i < rootCount - 1; ++i) {
+		l = (z - roots[i + 1].value()) * (l + r);
+		r *= (z - roots[i].value());
+	}
+	df = l + r;
+	f = r * (z - roots[rootCount - 1].value());
+}
+
+inline complex quotient(complex z, const QVector<Root> &roots)
+{
+	// f / f' of the newton step. Products of many roots over- or underflow,
+	// their log-derivative f' / f = sum 1 / (z - r_k) does not.
+	if (roots.count() <= nf::SRC) {
+		complex f, df;
+		func(z, f, df, roots);
+		return f / df;
+	}
+	complex sum(0, 0);
+	for (const Root &root : roots) {
+		const complex w = z - root.value();
+		const double n = norm(w);
+		if (n == 0) return complex(0, 0);
+		sum += conj(w) / n;
+	}
+	return 1.0 / sum;
+}
+
+inline quint8 stepFraction(double previous2, double last2)
+{
+	// Share of the last step, in log space, that was needed to get below
+	// nf::EPS, from the squared sizes of the last two steps. Newton steps
+	// shrink smoothly across a basin, so this interpolates the iterations.
+	const double eps2 = nf::EPS * nf::EPS;
+	if (!(previous2 > eps2) || !(last2 > 0) || last2 >= previous2) return 255;
+	const double t = std::log(previous2 / eps2) / std::log(previous2 / last2);
+	return quint8(qBound(0, qRound(255 * t), 255));
+}
+
+inline int findRoot(complex z, const Parameters &params, const RootTable *table)
+{
+	// Lowest root index within nf::EPS, a table looks up many roots in its grid
+	if (table != nullptr && !table->isEmpty()) return table->find(z.real(), z.imag());
+	const int rootCount = params.roots.count();
+	for (int r = 0; r < rootCount; ++r) {
+		if (abs(z - params.roots[r].value()) < nf::EPS) return r;
+	}
+	return -1;
+}
+
+inline int iterateZ(complex z, const Parameters &params, quint16 &iteration, quint16 first = 0, complex *last = nullptr,
+	quint8 *fraction = nullptr, const RootTable *table = nullptr)
+{
+	// Newton iteration, optionally continuing an orbit at iteration first.
+	// If given, last receives z of orbits that did not converge and
+	// fraction the share of the last iteration of orbits that did.
+	const complex d = params.damping;
+	double previous = 0;
+	for (iteration = first; iteration < params.maxIterations; ++iteration) {
+		complex z0 = z - d * quotient(z, params.roots); // <- expensive division
+
+		// If root has been found return its index
+		const double step = abs(z0 - z);
+		if (step < nf::EPS) {
+			const int r = findRoot(z0, params, table);
+			if (r >= 0) {
+				if (fraction != nullptr) *fraction = stepFraction(previous * previous, step * step);
+				return r;
+			}
+		}
+		previous = step;
+		z = z0;
+	}
+	if (last != nullptr) *last = z;
+	return -1;
+}
+
+inline void funcDD(const ddcomplex &z, ddcomplex &f, ddcomplex &df, const QVector<Root> &roots)
+{
+	// Same as func in double-double precision
+	const int rootCount = roots.length();
+	if (rootCount < 2) return;
+	ddcomplex r = z - ddcomplex(roots[0].value());
+	ddcomplex l = z - ddcomplex(roots[1].value());
+	for (int i = 1; i < rootCount - 1; ++i) {
+		l = (z - ddcomplex(roots[i + 1].value())) * (l + r);
+		r *= (z - ddcomplex(roots[i].value()));
+	}
+	df = l + r;
+	f = r * (z - ddcomplex(roots[rootCount - 1].value()));
+}
+
+inline ddcomplex quotientDD(const ddcomplex &z, const QVector<Root> &roots)
+{
+	// Same as quotient in double-double precision
+	if (roots.count() <= nf::SRC) {
+		ddcomplex f, df;
+		funcDD(z, f, df, roots);
+		return f / df;
+	}
+	const ddcomplex one(complex(1, 0));
+	ddcomplex sum(complex(0, 0));
+	for (const Root &root : roots) {
+		const ddcomplex w = z - ddcomplex(root.value());
+		if (w.re.hi == 0 && w.im.hi == 0) return ddcomplex(complex(0, 0));
+		sum += one / w;
+	}
+	return one / sum;
+}
+
+inline int iterateZDD(ddcomplex z, const Parameters &params, quint16 &iteration, quint8 *fraction = nullptr,
+	const RootTable *table = nullptr)
+{
+	// Newton iteration in double-double precision for views beyond double resolution
+	const complex d = params.damping;
+	double previous = 0;
+	for (iteration = 0; iteration < params.maxIterations; ++iteration) {
+		ddcomplex step = quotientDD(z, params.roots) * d;
+		z = z - step;
+
+		// Converged, the root check only needs double precision
+		const double size = abs(step.toComplex());
+		if (size < nf::EPS) {
+			const int r = findRoot(z.toComplex(), params, table);
+			if (r >= 0) {
+				if (fraction != nullptr) *fraction = stepFraction(previous * previous, size * size);
+				return r;
+			}
+		}
+		previous = size;
+	}
+	return -1;
+}
+
+inline QRgb shadeColor(const QColor &color, const Parameters &params, quint16 iteration, quint8 fraction = 255)
+{
+	// Darker the more iterations it took. Smooth coloring counts the last
+	// iteration only partly, so the shade has no bands.
+	if (params.coloring != COLORING_SMOOTH) return color.darker(60 + iteration * 8).rgb();
+	const double nu = qMax(0.0, iteration - 1 + fraction / 255.0);
+	return color.darker(qRound(60 + nu * 8)).rgb();
+}
+
+inline QRgb rootColor(const Parameters &params, int root, quint16 iteration, quint8 fraction = 255)
+{
+	// Root color shaded by iterations
+	if (root < 0) return qRgb(0, 0, 0);
+	return shadeColor(params.roots[root].color(), params, iteration, fraction);
+}
+
+inline QRgb lineColor(const ImageLine &il, int root, quint16 iteration, quint8 fraction = 255)
+{
+	// Equalised colors once the frame has been counted, fixed shading before
+	if (il.equalizer != nullptr) return il.equalizer->color(root, iteration);
+	return rootColor(*il.params, root, iteration, fraction);
+}
+
+// Newton iteration of up to nf::FLN points in single precision for up to
+// nf::SRC roots. Lanes keep iterating after they converged so the inner
+// loops stay branch free. Writes the root index per point, -1 if not
+// converged and -2 if float could overflow and the point must be
+// recomputed in double, and the share of the last iteration of converged
+// points.
+void iterateZF(const float *zx, const float *zy, int count, const Parameters &params, int *root, quint16 *iterations, quint8 *fractions);
+
+// Newton iteration of a custom f(z) for up to nf::FLN points in double
+// lanes like iterateZF. Writes where every point converged to, NaN if it
+// did not, since the roots are only known afterwards.
+void iterateZE(const double *zx, const double *zy, int count, const Parameters &params, const Expression &expression,
+	complex *points, quint16 *iterations, quint8 *fractions);
+
+// Newton iteration of up to nf::FLN points in double lanes for more than
+// nf::SRC roots, through the log-derivative over the table. Writes the root
+// index per point, -1 if not converged, and last z of those that did not.
+// If given, first holds the iteration every point resumes at.
+void iterateZR(const double *zx, const double *zy, int count, const Parameters &params, const RootTable &table,
+	int *root, quint16 *iterations, quint8 *fractions, complex *last, const quint16 *first = nullptr);
+
+// Iterate the pixels [begin, end) of a single image line
+void iterateX(ImageLine &il);
+
+// Fill the pixels of a line that iterateX skipped due to symmetry,
+// pixels holds the results of the whole frame
+void fillX(ImageLine &il, const Pixel *pixels);
+
+// Supersample the pixels of a line whose neighbours converge to another root
+// or take much longer, pixels holds the results of the whole frame
+void antialiasX(ImageLine &il, const Pixel *pixels, int height);
+
+// Render the given tile of an image with the given size into buffer.
+// The buffer holds tile.height() rows of stride pixels each.
+// Runs synchronously on the calling thread.
+void renderTile(const Parameters &params, QSize size, QRect tile, QRgb *buffer, int stride);
+
+#endif // NEWTON_H
@@ -0,0 +1,173 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "orbitfield.h"
+#include "newton.h"
+#include "tracer.h"
+#include <cmath>
+
+OrbitField::OrbitField() :
+	columns(0),
+	rows(0)
+{
+}
+
+OrbitField::OrbitField(const Parameters &params) :
+	params(params),
+	expression(Expression::compile(params.function)),
+	columns(qMax(1, params.size.width() / nf::OFG)),
+	rows(qMax(1, params.size.height() / nf::OFG)),
+	lines(columns * rows),
+	roots(columns * rows, -1)
+{
+	// Many roots go through a table
+	if (expression.isEmpty() && params.roots.count() > nf::SRC) table = RootTable(params.roots);
+}
+
+bool OrbitField::isEmpty() const
+{
+	// Nothing computed yet
+	return lines.isEmpty();
+}
+
+void OrbitField::computeRow(int row)
+{
+	// Roots or custom function and damping
+	const int rootCount = expression.isEmpty() ? params.roots.count() : 0;
+	if (expression.isEmpty() && rootCount < 2) return;
+	const int productCount = table.isEmpty() ? rootCount : 0;
+	QVector<double> rx(rootCount), ry(rootCount);
+	for (int k = 0; k < rootCount; ++k) {
+		rx[k] = params.roots[k].value().real();
+		ry[k] = params.roots[k].value().imag();
+	}
+	const double dr = params.damping.real();
+	const double di = params.damping.imag();
+	const double eps2 = nf::EPS * nf::EPS;
+
+	// Mapping between view pixels and complex plane
+	const double left = params.limits.left();
+	const double top = params.limits.top();
+	const double xFactor = params.limits.width() / (params.size.width() - 1);
+	const double yFactor = -params.limits.height() / (params.size.height() - 1);
+	const double py = (row + 0.5) * params.size.height() / rows;
+	QVector<QPointF> *rowLines = lines.data() + row * columns;
+	qint16 *rowRoots = roots.data() + row * columns;
+
+	// Starts of the row in batches of lanes, unused lanes repeat the first
+	for (int first = 0; first < columns; first += nf::FLN) {
+		const int count = qMin<int>(nf::FLN, columns - first);
+		double x[nf::FLN], y[nf::FLN];
+		bool active[nf::FLN];
+		for (int l = 0; l < nf::FLN; ++l) {
+			const double px = (first + (l < count ? l : 0) + 0.5) * params.size.width() / columns;
+			x[l] = px * xFactor + left;
+			y[l] = py * yFactor + top;
+			active[l] = l < count;
+			if (l < count) rowLines[first + l].append(QPointF(px, py));
+		}
+
+		// Newton steps, the lane loops are free of branches so they vectorize
+		int remaining = count;
+		for (int i = 0; i < nf::OFS && remaining > 0; ++i) {
+			double rr[nf::FLN], ri[nf::FLN], lr[nf::FLN], li[nf::FLN], step[nf::FLN];
+			double fr[nf::FLN], fi[nf::FLN], dfr[nf::FLN], dfi[nf::FLN], qr[nf::FLN], qi[nf::FLN];
+			if (!expression.isEmpty()) expression.evaluate(x, y, fr, fi, dfr, dfi);
+			for (int l = 0; l < nf::FLN && productCount > 0; ++l) {
+				rr[l] = x[l] - rx[0];
+				ri[l] = y[l] - ry[0];
+				lr[l] = x[l] - rx[1];
+				li[l] = y[l] - ry[1];
+			}
+			for (int k = 1; k < productCount - 1; ++k) {
+				for (int l = 0; l < nf::FLN; ++l) {
+					const double sr = lr[l] + rr[l], si = li[l] + ri[l];
+					const double ar = x[l] - rx[k + 1], ai = y[l] - ry[k + 1];
+					const double br = x[l] - rx[k], bi = y[l] - ry[k];
+					lr[l] = ar * sr - ai * si;
+					li[l] = ar * si + ai * sr;
+					const double tr = rr[l] * br - ri[l] * bi;
+					ri[l] = rr[l] * bi + ri[l] * br;
+					rr[l] = tr;
+				}
+			}
+			for (int l = 0; l < nf::FLN && productCount > 0; ++l) {
+				const double cr = x[l] - rx[productCount - 1], ci = y[l] - ry[productCount - 1];
+				dfr[l] = lr[l] + rr[l];
+				dfi[l] = li[l] + ri[l];
+				fr[l] = rr[l] * cr - ri[l] * ci;
+				fi[l] = rr[l] * ci + ri[l] * cr;
+			}
+			if (!table.isEmpty()) table.quotient(x, y, qr, qi);
+			for (int l = 0; l < nf::FLN && table.isEmpty(); ++l) {
+				const double den = dfr[l] * dfr[l] + dfi[l] * dfi[l];
+				qr[l] = (fr[l] * dfr[l] + fi[l] * dfi[l]) / den;
+				qi[l] = (fi[l] * dfr[l] - fr[l] * dfi[l]) / den;
+			}
+			for (int l = 0; l < nf::FLN; ++l) {
+				const double sr = dr * qr[l] - di * qi[l], si = dr * qi[l] + di * qr[l];
+				x[l] -= sr;
+				y[l] -= si;
+				step[l] = sr * sr + si * si;
+			}
+
+			// Record the active lanes, converged or diverged ones are done
+			for (int l = 0; l < count; ++l) {
+				if (!active[l]) continue;
+				if (!std::isfinite(x[l]) || !std::isfinite(y[l])) {
+					active[l] = false;
+					remaining--;
+					continue;
+				}
+				rowLines[first + l].append(QPointF((x[l] - left) / xFactor, (y[l] - top) / yFactor));
+				if (step[l] >= eps2) continue;
+				if (!table.isEmpty()) rowRoots[first + l] = table.find(x[l], y[l]);
+				for (int k = 0; k < productCount; ++k) {
+					const double ex = x[l] - rx[k], ey = y[l] - ry[k];
+					if (ex * ex + ey * ey < eps2) {
+						rowRoots[first + l] = k;
+						break;
+					}
+				}
+				active[l] = false;
+				remaining--;
+			}
+		}
+	}
+}
+
+QVector<QPoint> computeOrbit(Parameters params)
+{
+	// Create vector of points
+	NF_TRACE_SCOPE("renderOrbit", "renderer");
+	QVector<QPoint> orbit;
+	const complex d = params.damping;
+
+	// Create complex number from current pixel
+	complex z = params.point2complex(params.orbitStart);
+	orbit.append(params.complex2point(z));
+
+	// Newton iteration
+	const Expression expression = Expression::compile(params.function);
+	for (quint16 i = 0; i < params.maxIterations; ++i) {
+		complex q;
+		if (expression.isEmpty()) {
+			q = quotient(z, params.roots);
+		} else {
+			complex f, df;
+			expression.evaluate(z, f, df);
+			q = f / df;
+		}
+		complex z0 = z - d * q;
+
+		// Append point to vector
+		orbit.append(params.complex2point(z0));
+
+		// Break if root has been found
+		if (abs(z0 - z) < nf::EPS) break;
+		z = z0;
+	}
+	return orbit;
+}
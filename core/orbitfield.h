@@ -0,0 +1,40 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef ORBITFIELD_H
+#define ORBITFIELD_H
+
+#include "parameters.h"
+#include "expression.h"
+#include "roottable.h"
+#include <QPointF>
+#include <QMetaType>
+
+// Orbits of a grid of start points every nf::OFG pixels across the view,
+// each cut after nf::OFS steps, drawn as streamlines. Rows of the grid are
+// computed in parallel, the starts of a row nf::FLN at a time with lanes in
+// structure of arrays layout like iterateZF.
+
+struct OrbitField {
+	OrbitField();
+	OrbitField(const Parameters &params);
+	bool isEmpty() const;
+	void computeRow(int row);
+
+	Parameters params;
+	Expression expression;				// Custom f(z), compiled once for all rows
+	RootTable table;					// Roots beyond nf::SRC, built once for all rows
+	int columns;
+	int rows;
+	QVector<QVector<QPointF>> lines;	// View pixels of every orbit, row by row
+	QVector<qint16> roots;				// Root the orbit converges to, -1 if none
+};
+
+Q_DECLARE_METATYPE(OrbitField)
+
+// Orbit of params.orbitStart in view pixels
+QVector<QPoint> computeOrbit(Parameters params);
+
+#endif // ORBITFIELD_H
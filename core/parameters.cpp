@@ -0,0 +1,346 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "parameters.h"
+#include <QDateTime>
+#include <limits>
+#include <random>
+
+Parameters::Parameters() :
+	limits(Limits()),
+	size(nf::DSI, nf::DSI),
+	maxIterations(nf::DMI),
+	damping(nf::DDP),
+	scaleDownFactor(nf::DSC),
+	scaleDown(false),
+	frameBudget(nf::DFB),
+	capIterations(false),
+	processor(GPU_OPENGL),
+	orbitMode(false),
+	orbitStart(0, 0),
+	orbitField(false),
+	benchmark(false),
+	scaleUpFactor(1),
+	perturbation(true),
+	floatPrecision(true),
+	symmetry(true),
+	antiAliasing(SAMPLES_NONE),
+	densityMap(false),
+	coloring(COLORING_SHADED),
+	nativeFunction(false)
+{
+}
+
+bool Parameters::paramsChanged(const Parameters &other) const
+{
+	// Check for same root count
+	if (roots.count() != other.roots.count())
+		return true;
+
+	// Check for same roots
+	for (int i = 0; i < roots.count(); ++i) {
+		if (roots[i] != other.roots[i]) {
+			return true;
+		}
+	}
+
+	// Check for remaining parameters
+	return (
+		limits != other.limits ||
+		size != other.size ||
+		maxIterations != other.maxIterations ||
+		damping != other.damping ||
+		scaleDownFactor != other.scaleDownFactor ||
+		scaleDown != other.scaleDown ||
+		frameBudget != other.frameBudget ||
+		capIterations != other.capIterations ||
+		processor != other.processor ||
+		benchmark != other.benchmark ||
+		scaleUpFactor != other.scaleUpFactor ||
+		perturbation != other.perturbation ||
+		floatPrecision != other.floatPrecision ||
+		symmetry != other.symmetry ||
+		antiAliasing != other.antiAliasing ||
+		densityMap != other.densityMap ||
+		coloring != other.coloring ||
+		function != other.function ||
+		nativeFunction != other.nativeFunction
+	);
+}
+
+uint Parameters::hash() const
+{
+	// Hash of the fields paramsChanged compares, equal params hash equally
+	uint h = qHash(roots.count());
+	for (const Root &root : roots) {
+		h = qHash(root.value().real(), h);
+		h = qHash(root.value().imag(), h);
+		h = qHash(root.color().rgba(), h);
+	}
+	h = qHash(limits.leftDD().hi, qHash(limits.leftDD().lo, h));
+	h = qHash(limits.rightDD().hi, qHash(limits.rightDD().lo, h));
+	h = qHash(limits.topDD().hi, qHash(limits.topDD().lo, h));
+	h = qHash(limits.bottomDD().hi, qHash(limits.bottomDD().lo, h));
+	h = qHash(size.width(), qHash(size.height(), h));
+	h = qHash(maxIterations, h);
+	h = qHash(damping.real(), qHash(damping.imag(), h));
+	h = qHash(scaleDownFactor, qHash(scaleDown, h));
+	h = qHash(frameBudget, qHash(capIterations, h));
+	h = qHash(int(processor), qHash(benchmark, h));
+	h = qHash(scaleUpFactor, qHash(perturbation, h));
+	h = qHash(floatPrecision, qHash(symmetry, h));
+	h = qHash(int(antiAliasing), qHash(densityMap, h));
+	h = qHash(function, qHash(int(coloring), h));
+	return qHash(nativeFunction, h);
+}
+
+bool Parameters::orbitChanged(const Parameters &other) const
+{
+	// Check for orbit
+	return (
+		orbitStart != other.orbitStart ||
+		orbitMode != other.orbitMode ||
+		orbitField != other.orbitField ||
+		((orbitMode || orbitField) && paramsChanged(other))
+	);
+}
+
+void Parameters::resize(QSize newSize)
+{
+	// Update limits and size
+	limits.resize(newSize - size);
+	size = newSize;
+}
+
+void Parameters::reset()
+{
+	// Equidistant points on a circle
+	const int rootCount = roots.count();
+	for (int i = 0; i < rootCount; ++i) {
+		double angle = 2 * nf::PI * i / rootCount;
+		roots[i].setValue(complex(cos(angle), sin(angle)));
+	}
+
+	// Reset limits and scaledown
+	limits.reset(size);
+	scaleDown = false;
+}
+
+void Parameters::randomize()
+{
+	// Points spread evenly over the unit disc, the roots of a random polynomial
+	std::mt19937 generator{std::random_device()()};
+	std::uniform_real_distribution<double> uniform(0, 1);
+	for (Root &root : roots) {
+		double radius = std::sqrt(uniform(generator));
+		double angle = 2 * nf::PI * uniform(generator);
+		root.setValue(std::polar(radius, angle));
+	}
+
+	// Reset limits and scaledown
+	limits.reset(size);
+	scaleDown = false;
+}
+
+QPoint Parameters::complex2point(complex z)
+{
+	// Convert complex to point
+	int x = (z.real() - limits.left()) * (size.width() - 1) / limits.width();
+	int y = (z.imag() - limits.top()) * (size.height() - 1) / -limits.height();
+	return QPoint(x, y);
+}
+
+Precision Parameters::precision() const
+{
+	// Kernel precision the CPU renderer picks for the current view
+	return precision(size.width());
+}
+
+Precision Parameters::precision(int pixels) const
+{
+	// Custom functions only have a double kernel, deep views need more
+	if (!function.isEmpty())
+		return PRECISION_DOUBLE;
+	// Perturbation and float only exist for up to nf::SRC roots
+	if (limits.exceedsDouble(pixels))
+		return perturbation && roots.count() <= nf::SRC ? PRECISION_PERTURBATION : PRECISION_DOUBLE_DOUBLE;
+	if (!floatPrecision || roots.count() < 2 || roots.count() > nf::SRC)
+		return PRECISION_DOUBLE;
+
+	// Float if pixels and roots are well apart relative to the coordinates
+	double magnitude = qMax(qMax(qAbs(limits.left()), qAbs(limits.right())), qMax(qAbs(limits.top()), qAbs(limits.bottom())));
+	double closest = std::numeric_limits<double>::max();
+	for (int i = 0; i < roots.count(); ++i) {
+		magnitude = qMax(magnitude, abs(roots[i].value()));
+		for (int j = 0; j < i; ++j) {
+			closest = qMin(closest, abs(roots[i].value() - roots[j].value()));
+		}
+	}
+	double spacing = qMin(limits.width(), limits.height()) / qMax(1, pixels - 1);
+	bool safe = spacing > nf::FLT * magnitude && closest > nf::FLT * magnitude;
+	return safe ? PRECISION_FLOAT : PRECISION_DOUBLE;
+}
+
+complex Parameters::point2complex(QPoint p)
+{
+	// Convert point to complex
+	double real = p.x() * limits.width() / (size.width() - 1) + limits.left();
+	double imag = p.y() * -limits.height() / (size.height() - 1) + limits.top();
+	return complex(real, imag);
+}
+
+complex Parameters::distance2complex(QPointF d)
+{
+	// Convert distance to complex
+	double real = d.x() * limits.width() / (size.width() - 1);
+	double imag = d.y() * -limits.height() / (size.height() - 1);
+	return complex(real, imag);
+}
+
+int Parameters::rootContainsPoint(QPoint point)
+{
+	// Check if root contains point
+	const int rootCount = roots.count();
+	for (int i = 0; i < rootCount; ++i) {
+		QPoint dist = complex2point(roots[i].value()) - point;
+		if (abs(dist.x()) < nf::RIR && abs(dist.y()) < nf::RIR) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+QVector<QVector2D> Parameters::rootsVec2()
+{
+	// Return vector of root values only
+	QVector<QVector2D> vec2;
+	const int rootCount = roots.count();
+	for (int i = 0; i < rootCount; ++i) {
+		vec2.append(roots[i].valueVec2());
+	}
+	return vec2;
+}
+
+QVector<QVector3D> Parameters::colorsVec3()
+{
+	// Return vector of root colors only
+	QVector<QVector3D> vec3;
+	const int rootCount = roots.count();
+	for (int i = 0; i < rootCount; ++i) {
+		vec3.append(roots[i].colorVec3());
+	}
+	return vec3;
+}
+
+complex string2complex(const QString &text)
+{
+	// Convert string to complex
+	bool sign = false;
+	double real = 0, imag = 0;
+	QStringList parts = text.split('i');
+	QString rstr = parts.first().simplified();
+
+	// Get imag sign from first part
+	int si = rstr.indexOf('-', 1);
+	if (si > 0) {
+		sign = true;
+		rstr.replace(si, 1, ' ');
+	} else rstr.replace('+', ' ');
+
+	// Get real
+	real = rstr.simplified().toDouble();
+
+	// Get imag
+	if (parts.length() >= 2) {
+		imag = parts[1].simplified().toDouble();
+		if (sign) imag = -imag;
+	}
+
+	// Return complex number
+	return (complex(real, imag));
+}
+
+QString complex2string(complex z, quint8 precision)
+{
+	// Convert complex to string
+	static QString complexFormat("%1 %2 i%3");
+	QString real = QString::number(z.real(), 'f', precision);
+	QString imag = QString::number(abs(z.imag()), 'f', precision);
+	QString sign = z.imag() >= 0 ? "+" : "-";
+	return complexFormat.arg(real, sign, imag);
+}
+
+QString precision2string(Precision precision)
+{
+	// Short name of kernel precision
+	switch (precision) {
+	case PRECISION_FLOAT: return "float";
+	case PRECISION_DOUBLE_DOUBLE: return "double-double";
+	case PRECISION_PERTURBATION: return "perturbation";
+	default: return "double";
+	}
+}
+
+QString samples2string(SamplePattern pattern)
+{
+	// Short name of sample pattern
+	switch (pattern) {
+	case SAMPLES_GRID4: return "grid4";
+	case SAMPLES_ROTATED4: return "rotated4";
+	case SAMPLES_GRID9: return "grid9";
+	case SAMPLES_GRID16: return "grid16";
+	default: return "none";
+	}
+}
+
+QString coloring2string(Coloring coloring)
+{
+	// Short name of coloring
+	switch (coloring) {
+	case COLORING_EQUALIZED: return "equalized";
+	case COLORING_SMOOTH: return "smooth";
+	default: return "shaded";
+	}
+}
+
+QVector<QPointF> samplePattern(SamplePattern pattern)
+{
+	// Sample offsets within a pixel, relative to its centre
+	QVector<QPointF> offsets;
+	int n = 0;
+	switch (pattern) {
+	case SAMPLES_ROTATED4:
+		offsets << QPointF(-0.125, -0.375) << QPointF(0.375, -0.125)
+			<< QPointF(0.125, 0.375) << QPointF(-0.375, 0.125);
+		return offsets;
+	case SAMPLES_GRID4: n = 2; break;
+	case SAMPLES_GRID9: n = 3; break;
+	case SAMPLES_GRID16: n = 4; break;
+	default: return offsets;
+	}
+	for (int y = 0; y < n; ++y) {
+		for (int x = 0; x < n; ++x) {
+			offsets << QPointF((x + 0.5) / n - 0.5, (y + 0.5) / n - 0.5);
+		}
+	}
+	return offsets;
+}
+
+QVector2D complex2vec2(complex z)
+{
+	// Convert complex to vec2
+	return QVector2D(z.real(), z.imag());
+}
+
+QString dynamicFileName(const Parameters &params, const QString &ext)
+{
+	// Generate dynamic filename
+	QSize s = params.size * (params.benchmark ? params.scaleUpFactor : 1);
+	return("fractal_" +
+		QDateTime::currentDateTime().toString("yyMMdd_HHmmss_") +
+		QString::number(params.roots.count()) + "roots_" +
+		QString::number(s.width()) + "x" + QString::number(s.height()) + "." + ext
+	);
+}
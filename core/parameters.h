@@ -10,6 +10,8 @@
 #include "limits.h"
 #include "root.h"
 #include <QSize>
+#include <QString>
+#include <QPointF>
 #include <QVector>
 #include <QVector2D>
 #include <QVector3D>
@@ -20,12 +22,37 @@ enum Processor {
 	GPU_OPENGL
 };
 
+enum Precision {
+	PRECISION_FLOAT,
+	PRECISION_DOUBLE,
+	PRECISION_DOUBLE_DOUBLE,
+	PRECISION_PERTURBATION
+};
+
+enum SamplePattern {
+	SAMPLES_NONE,		// No anti-aliasing
+	SAMPLES_GRID4,		// 2x2 grid
+	SAMPLES_ROTATED4,	// Rotated 2x2 grid
+	SAMPLES_GRID9,		// 3x3 grid
+	SAMPLES_GRID16		// 4x4 grid
+};
+
+enum Coloring {
+	COLORING_SHADED,	// Darker with every iteration
+	COLORING_EQUALIZED,	// Shades spread evenly over the pixels of every root
+	COLORING_SMOOTH		// Darker with every iteration, the last one counts partly
+};
+
 struct Parameters {
 	Parameters();
 	bool paramsChanged(const Parameters &other) const;
 	bool orbitChanged(const Parameters &other) const;
+	uint hash() const;
 	void resize(QSize newSize);
 	void reset();
+	void randomize();
+	Precision precision() const;
+	Precision precision(int pixels) const;
 
 	complex point2complex(QPoint p);
 	QPoint  complex2point(complex z);
@@ -41,16 +68,31 @@ struct Parameters {
 	complex damping;
 	double scaleDownFactor;
 	bool scaleDown;
+	double frameBudget; // <- ms, 0 keeps scaleDownFactor fixed
+	bool capIterations;
 	Processor processor;
 	bool orbitMode;
 	QPoint orbitStart;
+	bool orbitField;
 	bool benchmark;
 	uint scaleUpFactor;
+	bool perturbation;
+	bool floatPrecision;
+	bool symmetry;
+	SamplePattern antiAliasing;
+	bool densityMap;
+	Coloring coloring;
+	QString function; // <- custom f(z), empty uses the roots
+	bool nativeFunction; // <- compile f(z) to machine code
 };
 
 // Does not really belong here, but I don't care
 complex string2complex(const QString &text);
 QString complex2string(complex z, quint8 precision = 2);
+QString precision2string(Precision precision);
+QString samples2string(SamplePattern pattern);
+QString coloring2string(Coloring coloring);
+QVector<QPointF> samplePattern(SamplePattern pattern);
 QVector2D complex2vec2(complex z);
 QString dynamicFileName(const Parameters &params, const QString &ext);
 
@@ -0,0 +1,251 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "perfcounters.h"
+#include <QFile>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+struct ThreadCounters {
+	ThreadCounters();
+	~ThreadCounters();
+	int fd[PerfCounterCount];
+	bool attached;
+};
+
+#ifdef Q_OS_LINUX
+static int openCounter(PerfCounter counter)
+{
+	// Count user space of the calling thread on any cpu
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	switch (counter) {
+	case PerfCycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+	case PerfInstructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+	case PerfBranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+	case PerfCacheMisses:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_LL
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	default: return -1;
+	}
+	return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+static quint64 readCounter(int fd)
+{
+	// Scale up if the kernel had to multiplex counters
+	quint64 data[3] = {0, 0, 0};
+	if (fd < 0 || ::read(fd, data, sizeof(data)) != sizeof(data)) return 0;
+	if (data[2] == 0) return 0;
+	if (data[2] >= data[1]) return data[0];
+	return quint64(double(data[0]) * data[1] / data[2]);
+}
+#endif
+
+ThreadCounters::ThreadCounters() :
+	attached(false)
+{
+	for (int c = 0; c < PerfCounterCount; ++c) fd[c] = -1;
+}
+
+ThreadCounters::~ThreadCounters()
+{
+	// Keep the final counts of exiting threads
+	if (attached) PerfCounters::instance().retire(this);
+}
+
+PerfCounts::PerfCounts()
+{
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		value[c] = 0;
+		available[c] = false;
+	}
+}
+
+PerfCounts PerfCounts::operator-(const PerfCounts &other) const
+{
+	// Difference of two readings, counters never run backwards
+	PerfCounts result = *this;
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		result.value[c] = value[c] > other.value[c] ? value[c] - other.value[c] : 0;
+	}
+	return result;
+}
+
+PerfCounts &PerfCounts::operator+=(const PerfCounts &other)
+{
+	// Sum of two readings
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		value[c] += other.value[c];
+		available[c] = available[c] || other.available[c];
+	}
+	return *this;
+}
+
+bool PerfCounts::isValid() const
+{
+	// At least cycles have been counted
+	return available[PerfCycles] && value[PerfCycles] > 0;
+}
+
+double PerfCounts::ipc() const
+{
+	// Instructions per cycle
+	if (!isValid() || !available[PerfInstructions]) return 0;
+	return double(value[PerfInstructions]) / value[PerfCycles];
+}
+
+double PerfCounts::perCycle(quint64 count) const
+{
+	// Any count, e.g. newton iterations, per cycle
+	return isValid() ? double(count) / value[PerfCycles] : 0;
+}
+
+PerfCounters &PerfCounters::instance()
+{
+	// Process wide counters
+	static PerfCounters counters;
+	return counters;
+}
+
+const char *PerfCounters::name(PerfCounter counter)
+{
+	// Names as used in benchmark output
+	switch (counter) {
+	case PerfCycles: return "cycles";
+	case PerfInstructions: return "instructions";
+	case PerfBranchMisses: return "branchMisses";
+	case PerfCacheMisses: return "llcMisses";
+	default: return "";
+	}
+}
+
+PerfCounters::PerfCounters() :
+	enabled_(0),
+	probed_(false)
+{
+	for (int c = 0; c < PerfCounterCount; ++c) available_[c] = false;
+}
+
+bool PerfCounters::isAvailable()
+{
+	// Probe once by opening every counter on the calling thread
+	QMutexLocker locker(&mutex_);
+	if (probed_) return available_[PerfCycles];
+	probed_ = true;
+#ifdef Q_OS_LINUX
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		int fd = openCounter(PerfCounter(c));
+		if (fd >= 0) {
+			available_[c] = true;
+			close(fd);
+		} else if (c == PerfCycles) {
+			error_ = QString("perf_event_open: %1").arg(strerror(errno));
+			QFile paranoid("/proc/sys/kernel/perf_event_paranoid");
+			if (paranoid.open(QIODevice::ReadOnly)) {
+				error_ += QString(" (perf_event_paranoid = %1)").arg(QString(paranoid.readAll()).trimmed());
+			}
+		}
+	}
+	if (!available_[PerfCycles]) {
+		for (int c = 0; c < PerfCounterCount; ++c) available_[c] = false;
+	}
+#else
+	error_ = "Hardware counters are only supported on Linux";
+#endif
+	return available_[PerfCycles];
+}
+
+QString PerfCounters::error()
+{
+	// Reason why counters are unavailable
+	isAvailable();
+	QMutexLocker locker(&mutex_);
+	return error_;
+}
+
+void PerfCounters::acquire()
+{
+	// Start attaching worker threads, nothing happens if unavailable
+	if (isAvailable()) enabled_.ref();
+}
+
+void PerfCounters::release()
+{
+	// Stop attaching new threads, open counters keep running
+	if (enabled_.loadAcquire() > 0) enabled_.deref();
+}
+
+void PerfCounters::attachThread()
+{
+	// Open counters of the calling thread
+	thread_local ThreadCounters counters;
+	if (counters.attached) return;
+	counters.attached = true;
+#ifdef Q_OS_LINUX
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		if (available_[c]) counters.fd[c] = openCounter(PerfCounter(c));
+	}
+#endif
+	QMutexLocker locker(&mutex_);
+	threads_.append(&counters);
+}
+
+PerfCounts PerfCounters::read()
+{
+	// Sum over all attached and exited threads
+	QMutexLocker locker(&mutex_);
+	PerfCounts counts = retired_;
+	for (const ThreadCounters *counters : threads_) {
+		counts += readThread(counters);
+	}
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		counts.available[c] = available_[c];
+	}
+	return counts;
+}
+
+void PerfCounters::retire(ThreadCounters *counters)
+{
+	// Fold final counts into retired and close
+	QMutexLocker locker(&mutex_);
+	retired_ += readThread(counters);
+	threads_.removeOne(counters);
+#ifdef Q_OS_LINUX
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		if (counters->fd[c] >= 0) close(counters->fd[c]);
+		counters->fd[c] = -1;
+	}
+#endif
+}
+
+PerfCounts PerfCounters::readThread(const ThreadCounters *counters) const
+{
+	// Read counters of one thread
+	PerfCounts counts;
+#ifdef Q_OS_LINUX
+	for (int c = 0; c < PerfCounterCount; ++c) {
+		counts.value[c] = readCounter(counters->fd[c]);
+		counts.available[c] = counters->fd[c] >= 0;
+	}
+#else
+	Q_UNUSED(counters);
+#endif
+	return counts;
+}
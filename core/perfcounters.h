@@ -0,0 +1,79 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QAtomicInt>
+
+// Hardware performance counters via perf_event_open (Linux only).
+// Every worker thread opens its own counters the first time it renders a
+// line while counting is enabled, a frame is the difference of the sums
+// before and after. If counters cannot be opened (other platforms,
+// perf_event_paranoid, containers), isAvailable() returns false, error()
+// tells why and all counts stay zero.
+
+enum PerfCounter {
+	PerfCycles,
+	PerfInstructions,
+	PerfBranchMisses,
+	PerfCacheMisses,
+	PerfCounterCount
+};
+
+struct PerfCounts {
+	PerfCounts();
+	PerfCounts operator-(const PerfCounts &other) const;
+	PerfCounts &operator+=(const PerfCounts &other);
+	bool isValid() const;
+	double ipc() const;
+	double perCycle(quint64 count) const;
+
+	quint64 value[PerfCounterCount];
+	bool available[PerfCounterCount];
+};
+
+struct ThreadCounters;
+
+class PerfCounters
+{
+public:
+	static PerfCounters &instance();
+	static const char *name(PerfCounter counter);
+	bool isAvailable();
+	QString error();
+	bool isEnabled() const { return enabled_.loadAcquire() > 0; }
+	void acquire();
+	void release();
+	void attachThread();
+	PerfCounts read();
+
+protected:
+	PerfCounters();
+	void retire(ThreadCounters *counters);
+	PerfCounts readThread(const ThreadCounters *counters) const;
+
+private:
+	friend struct ThreadCounters;
+	QAtomicInt enabled_;
+	QMutex mutex_;
+	bool probed_;
+	bool available_[PerfCounterCount];
+	QString error_;
+	QVector<ThreadCounters*> threads_;
+	PerfCounts retired_;
+};
+
+inline void perfAttachThread()
+{
+	// Open counters for the calling worker once, if anyone is counting
+	PerfCounters &counters = PerfCounters::instance();
+	if (counters.isEnabled()) counters.attachThread();
+}
+
+#endif // PERFCOUNTERS_H
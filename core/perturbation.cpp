@@ -0,0 +1,61 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "perturbation.h"
+#include "tracer.h"
+
+ReferenceOrbit::ReferenceOrbit() :
+	rootCount(0),
+	length(0)
+{
+}
+
+ReferenceOrbit::ReferenceOrbit(const Parameters &params, const ddcomplex &center) :
+	center(center),
+	rootCount(params.roots.count()),
+	length(0)
+{
+	// Iterate the reference in double-double until it converges
+	NF_TRACE_SCOPE("ReferenceOrbit", "renderer");
+	const complex d = params.damping;
+	ddcomplex z = center;
+	this->z.append(z);
+	if (rootCount < 2 || rootCount > nf::SRC) return;
+	for (quint16 n = 0; n < params.maxIterations; ++n) {
+
+		// Offsets to the roots, stop if the reference sits on one
+		QVector<complex> a(rootCount);
+		for (int k = 0; k < rootCount; ++k) {
+			a[k] = (z - ddcomplex(params.roots[k].value())).toComplex();
+			if (a[k] == complex(0, 0)) return;
+		}
+
+		// Newton step with g = f'/f
+		ddcomplex f, df;
+		funcDD(z, f, df, params.roots);
+		ddcomplex g = df / f;
+		ddcomplex z0 = z - ddcomplex(d) * (ddcomplex(complex(1, 0)) / g);
+
+		// Store the step
+		for (int k = 0; k < rootCount; ++k) {
+			offsets.append(a[k]);
+			inverses.append(complex(1, 0) / a[k]);
+		}
+		this->g.append(g.toComplex());
+		step.append((z0 - z).toComplex());
+		this->z.append(z0);
+		length++;
+
+		// Converged, pixels continue on their own from here
+		if (abs(step.last()) < nf::EPS) return;
+		z = z0;
+	}
+}
+
+bool ReferenceOrbit::isEmpty() const
+{
+	// Not computed
+	return z.isEmpty();
+}
@@ -0,0 +1,106 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef PERTURBATION_H
+#define PERTURBATION_H
+
+#include "newton.h"
+
+// Perturbation rendering for deep zooms. With g = f'/f = sum 1 / (z - r_k)
+// the newton step is z - d / g. One reference orbit Z_n is iterated in
+// double-double at the view centre, every pixel z_n = Z_n + delta_n only
+// iterates its small delta in double:
+//
+//   A_k = Z_n - r_k,  G = g(Z_n)
+//   dg  = g(z_n) - G = -delta * sum 1 / (A_k * (A_k + delta))
+//   delta_n+1 = delta_n + d * dg / (G * (G + dg))
+//
+// The formula is exact and free of cancellation as long as the pixel is not
+// much closer to a root than the reference (glitch) and delta stays small.
+// Otherwise, or once the reference orbit ends, the pixel is rebased onto
+// its absolute position and continues with the plain double kernel.
+
+struct ReferenceOrbit {
+	ReferenceOrbit();
+	ReferenceOrbit(const Parameters &params, const ddcomplex &center);
+	bool isEmpty() const;
+	const complex *a(int n) const { return offsets.constData() + n * rootCount; }
+	const complex *b(int n) const { return inverses.constData() + n * rootCount; }
+
+	ddcomplex center;
+	int rootCount;
+	int length;					// Steps, z holds one state more
+	QVector<ddcomplex> z;		// Z_n
+	QVector<complex> g;			// g(Z_n)
+	QVector<complex> step;		// Z_n+1 - Z_n
+	QVector<complex> offsets;	// Z_n - r_k, rootCount per n
+	QVector<complex> inverses;	// 1 / (Z_n - r_k)
+};
+
+inline int iterateDelta(complex delta, const ReferenceOrbit &ref, const Parameters &params, quint16 &iteration, quint8 *fraction = nullptr)
+{
+	// Iterate the offset of a pixel from the reference orbit
+	const int rootCount = ref.rootCount;
+	const int paramsRootCount = params.roots.count();
+	const complex d = params.damping;
+	double previous = 0;
+	for (iteration = 0; iteration < params.maxIterations; ++iteration) {
+
+		// Reference ended or pixel drifted away, continue in plain double
+		const int n = iteration;
+		if (n >= ref.length || norm(delta) > nf::PRT * nf::PRT) break;
+
+		// w_k = A_k + delta, stop on glitch where the pixel is much closer to a root
+		const complex *a = ref.a(n);
+		const complex *b = ref.b(n);
+		complex w[nf::SRC];
+		bool glitch = false;
+		for (int k = 0; k < rootCount; ++k) {
+			w[k] = a[k] + delta;
+			glitch |= norm(w[k]) < nf::GLT * nf::GLT * norm(a[k]);
+		}
+		if (glitch) break;
+
+		// Invert all w_k with a single division
+		complex prefix[nf::SRC];
+		complex acc(1, 0);
+		for (int k = 0; k < rootCount; ++k) {
+			prefix[k] = acc;
+			acc *= w[k];
+		}
+		complex inv = complex(1, 0) / acc;
+		complex sum(0, 0);
+		for (int k = rootCount - 1; k >= 0; --k) {
+			sum += b[k] * (inv * prefix[k]);
+			inv *= w[k];
+		}
+
+		// Perturbed newton step
+		const complex G = ref.g[n];
+		const complex dg = -delta * sum;
+		const complex dstep = d * dg / (G * (G + dg));
+		delta += dstep;
+
+		// If root has been found return its index
+		const double step = abs(ref.step[n] + dstep);
+		if (step < nf::EPS) {
+			complex z0 = (ref.z[n + 1] + ddcomplex(delta)).toComplex();
+			for (int r = 0; r < paramsRootCount; ++r) {
+				if (abs(z0 - params.roots[r].value()) < nf::EPS) {
+					if (fraction != nullptr) *fraction = stepFraction(previous * previous, step * step);
+					return r;
+				}
+			}
+		}
+		previous = step;
+	}
+
+	// Rebase onto the absolute position
+	if (iteration >= params.maxIterations) return -1;
+	complex z = (ref.z[iteration] + ddcomplex(delta)).toComplex();
+	return iterateZ(z, params, iteration, iteration, nullptr, fraction);
+}
+
+#endif // PERTURBATION_H
@@ -0,0 +1,788 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "renderer.h"
+#include "perturbation.h"
+#include "tracer.h"
+#include <QImage>
+#include <QFutureWatcher>
+
+Renderer::Renderer(QObject *parent) :
+	QObject(parent),
+	threadCount_(0),
+	invalidated_(false),
+	statsEnabled_(false),
+	refinementEnabled_(false),
+	fps_(0),
+	countersEnabled_(false),
+	frame_(0),
+	equalized_(false),
+	pass_(PASS_ITERATE),
+	complete_(false),
+	iterations_(0),
+	refined_(SAMPLES_NONE),
+	stale_(false),
+	prefetched_(false),
+	scale_(1),
+	ramping_(false),
+	generation_(0),
+	wakeup_(0),
+	next_(new Snapshot(Parameters(), 0)),
+	cur_(next_),
+	watcher_(this),
+	orbitWatcher_(this),
+	fieldWatcher_(this),
+	orbitStale_(false),
+	fieldStale_(false),
+	kernelWatcher_(this)
+{
+	// Connect signals
+	connect(&watcher_, &QFutureWatcher<void>::finished, this, &Renderer::onFinished);
+	connect(&watcher_, &QFutureWatcher<void>::progressValueChanged, this, &Renderer::onProgressChanged);
+	connect(&orbitWatcher_, &QFutureWatcher<QVector<QPoint>>::finished, this, &Renderer::onOrbitFinished);
+	connect(&fieldWatcher_, &QFutureWatcher<void>::finished, this, &Renderer::onFieldFinished);
+	connect(&kernelWatcher_, &QFutureWatcher<NativeFunction>::finished, this, &Renderer::onKernelFinished);
+	kernelPool_.setMaxThreadCount(1);
+}
+
+Renderer::~Renderer()
+{
+	// Cleanup, workers must not outlive the image they write to
+	watcher_.cancel();
+	watcher_.waitForFinished();
+	orbitWatcher_.waitForFinished();
+	fieldWatcher_.cancel();
+	fieldWatcher_.waitForFinished();
+	kernelWatcher_.waitForFinished();
+	setCountersEnabled(false);
+}
+
+void Renderer::render(const Parameters &params)
+{
+	// Publish a snapshot from any thread, only the first one since the
+	// renderer last woke up posts another wake up
+	NF_TRACE_SCOPE("Renderer::render", "handoff");
+	mailbox_.publish(SnapshotPtr(new Snapshot(params, generation_.fetchAndAddOrdered(1) + 1)));
+	if (wakeup_.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, "onPublished", Qt::AutoConnection);
+}
+
+void Renderer::onPublished()
+{
+	// Run if not running, idle refinement gives way at once
+	wakeup_.storeRelease(0);
+	receive();
+	if (!watcher_.isRunning()) {
+		run();
+		return;
+	}
+
+	// Orbits do not wait for the frame, the workers never read orbit fields
+	if (orbitPending() && !paramsPending()) {
+		curParams_.orbitMode = next_->params.orbitMode;
+		curParams_.orbitStart = next_->params.orbitStart;
+		curParams_.orbitField = next_->params.orbitField;
+		cur_ = next_;
+		renderOrbit();
+		renderField();
+	}
+	if ((pass_ >= PASS_REFINE_ITERATIONS || ramping_) && (invalidated_ || paramsPending()))
+		watcher_.future().cancel();
+}
+
+void Renderer::stop()
+{
+	// Stop if running
+	if (watcher_.isRunning())
+		watcher_.future().cancel();
+}
+
+void Renderer::invalidate()
+{
+	// Render next params even if they did not change
+	invalidated_ = true;
+}
+
+void Renderer::setThreadCount(uint count)
+{
+	// Override thread count of multicore rendering, 0 -> ideal
+	threadCount_ = count;
+}
+
+uint Renderer::threadCount() const
+{
+	// Return thread count used for the current params
+	if (curParams_.processor == CPU_SINGLE) return 1;
+	return threadCount_ > 0 ? threadCount_ : QThread::idealThreadCount();
+}
+
+void Renderer::setStatsEnabled(bool enabled)
+{
+	// Record per line statistics from the next frame on
+#ifndef NF_NO_STATS
+	if (enabled != statsEnabled_) invalidate();
+	statsEnabled_ = enabled;
+#else
+	Q_UNUSED(enabled);
+#endif
+}
+
+bool Renderer::statsEnabled() const
+{
+	// Return if statistics are being recorded
+	return statsEnabled_;
+}
+
+void Renderer::setCountersEnabled(bool enabled)
+{
+	// Count cycles, instructions and misses of the workers per frame, also
+	// without statistics
+	if (enabled == countersEnabled_) return;
+	if (enabled) PerfCounters::instance().acquire();
+	else PerfCounters::instance().release();
+	countersEnabled_ = enabled;
+}
+
+bool Renderer::countersEnabled() const
+{
+	// Return if hardware counters are being read
+	return countersEnabled_;
+}
+
+void Renderer::setRefinementEnabled(bool enabled)
+{
+	// Keep refining interactive frames while no new params arrive
+	refinementEnabled_ = enabled;
+}
+
+bool Renderer::refinementEnabled() const
+{
+	// Return if idle refinement is enabled
+	return refinementEnabled_;
+}
+
+const FrameStats &Renderer::frameStats() const
+{
+	// Statistics of the last finished frame
+	return stats_;
+}
+
+void Renderer::onProgressChanged(int value)
+{
+	// Emit signal if benchmarking
+	if (curParams_.benchmark && pass_ == PASS_ITERATE)
+		emit benchmarkProgress(watcher_.progressMinimum(), watcher_.progressMaximum(), value);
+}
+
+void Renderer::onFinished()
+{
+	// Idle refinement went through or gave way to new params
+	NF_TRACE_SCOPE("Renderer::onFinished", "renderer");
+	const bool cancelled = watcher_.isCanceled();
+	if (ramping_ && cancelled) {
+		ramping_ = false;
+		run();
+
+		// Params went back to the ramped view, render it once more
+		if (!watcher_.isRunning()) {
+			invalidated_ = true;
+			run();
+		}
+		return;
+	}
+	if (pass_ >= PASS_REFINE_ITERATIONS) {
+		// Filling and equalising follow new iterations before they are shown
+		const bool follows = pass_ == PASS_REFINE_HISTOGRAM ||
+			(pass_ == PASS_REFINE_ITERATIONS && !symmetry_.isEmpty()) ||
+			(pass_ <= PASS_REFINE_FILL && equalizing());
+		if (pass_ == PASS_PREFETCH) prefetched_ = !cancelled;
+		else if (cancelled) stale_ = stale_ || pass_ == PASS_REFINE_EDGES;
+		else if (!follows)
+			emit fractalRendered(imagep_->copy(), fps_);
+		if (!cancelled && refine()) return;
+
+		// Pick up where refinement stopped if only the orbit moved
+		run();
+		if (!watcher_.isRunning()) refine();
+		return;
+	}
+
+	// Run the remaining passes over all lines
+	if (!linesp_.isNull() && !cancelled && nextPass()) return;
+
+	// Finish frame
+	complete_ = !cancelled;
+	Tracer::instance().asyncEnd("frame", "frame", frame_);
+	if (countersEnabled_) {
+		stats_.counters = PerfCounters::instance().read() - countersStart_;
+	}
+	if (!stats_.isEmpty()) {
+		stats_.end = statsClock();
+		emit statsRecorded(stats_);
+	}
+
+	// Time per pixel for the budget of the next interactive frames
+	if (complete_ && !curParams_.benchmark && !imagep_.isNull())
+		budget_.record(curParams_, timer_.nsecsElapsed() / 1e6, imagep_->width() * imagep_->height(), iterations_);
+
+	// Emit signal
+	fps_ = 1000.0 / qMax<qint64>(1, timer_.elapsed());
+	if (!imagep_.isNull()) {
+		if (curParams_.benchmark) emit benchmarkFinished(imagep_->copy());
+		else emit fractalRendered(imagep_->copy(), fps_);
+	}
+
+	// Params that arrived during the frame come first, then use the idle time
+	receive();
+	if (invalidated_ || paramsPending() || orbitPending()) run();
+	if (!watcher_.isRunning() && !rampUp()) refine();
+}
+
+void Renderer::run()
+{
+	// Start timer to measure fps
+	NF_TRACE_SCOPE("Renderer::run", "renderer");
+	timer_.start();
+	receive();
+	bool paramsChanged = invalidated_ || paramsPending();
+	if (paramsChanged && !invalidated_ && finalFrame(next_->params))
+		paramsChanged = false;
+	bool orbitChanged = orbitPending();
+	bool resume = !invalidated_ && resumable(next_->params);
+	if (paramsChanged || orbitChanged || cur_ != next_) {
+		curParams_ = next_->params;
+		cur_ = next_;
+	}
+	if (!paramsChanged && !orbitChanged) return;
+
+	// Rerender pixmap unless panned within the prefetched margin
+	bool prefetched = paramsChanged && !invalidated_ && !resume && fromPrefetch();
+	invalidated_ = false;
+	ramping_ = false;
+	if (paramsChanged && !prefetched)
+		renderFractal(resume);
+
+	// Rerender orbit and orbit field
+	if (orbitChanged && !curParams_.benchmark) {
+		renderOrbit();
+		renderField();
+	}
+}
+
+void Renderer::receive()
+{
+	// Latest published snapshot, if any arrived
+	SnapshotPtr snapshot = mailbox_.take();
+	if (!snapshot.isNull()) next_ = snapshot;
+}
+
+bool Renderer::paramsPending() const
+{
+	// Received params differ from the ones of the current frame
+	return next_->paramsChanged(*cur_);
+}
+
+bool Renderer::orbitPending() const
+{
+	// Received orbit differs from the current one
+	return next_->orbitChanged(*cur_);
+}
+
+bool Renderer::resumable(const Parameters &params) const
+{
+	// Only maxIterations went up since the last complete frame
+	if (!complete_ || orbits_.isEmpty() || params.maxIterations <= qMax(curParams_.maxIterations, iterations_))
+		return false;
+	Parameters same = params;
+	same.maxIterations = curParams_.maxIterations;
+	return !same.paramsChanged(curParams_);
+}
+
+bool Renderer::finalFrame(const Parameters &params) const
+{
+	// Only scaleDown changed and the frame ramped up to full quality already
+	if (!complete_ || imagep_.isNull() || imagep_->size() != params.size || iterations_ < params.maxIterations)
+		return false;
+	Parameters same = params;
+	same.scaleDown = curParams_.scaleDown;
+	return !same.paramsChanged(curParams_);
+}
+
+void Renderer::renderFractal(bool resume)
+{
+	// OpenGL not here
+	complete_ = false;
+	if (curParams_.processor == GPU_OPENGL) {
+		emit fractalRendered(QImage(), 0);
+		return;
+	}
+
+	// Get new size
+	NF_TRACE_SCOPE("renderFractal setup", "renderer");
+	Tracer::instance().asyncBegin("frame", "frame", ++frame_);
+	bool bm = curParams_.benchmark;
+	bool sd = curParams_.scaleDown;
+
+	// Interactive frames fit the frame time budget, ramping up raises the
+	// scale first and the iteration cap second
+	quint16 iterations = curParams_.maxIterations;
+	if (bm) scale_ = curParams_.scaleUpFactor;
+	else if (resume) iterations = curParams_.maxIterations;
+	else if (!sd) scale_ = 1;
+	else if (!ramping_) {
+		scale_ = budget_.scale(curParams_);
+		iterations = budget_.iterations(curParams_);
+	} else if (scale_ < 1) {
+		scale_ = qMin(1.0, scale_ * nf::SCG);
+		iterations = iterations_;
+	} else iterations = qMin<int>(iterations, 2 * iterations_);
+	QSize size = (curParams_.size * scale_).expandedTo(QSize(2, 2));
+
+	// TODO: Allocate memory on hard disk and write directly to a file
+	// Otherwise RAM won't be enough
+	// Until then, the max size is 32767x32767 pixels
+	if (bm && (size.width() > 32767 || size.height() > 32767)) {
+		emit benchmarkFinished(QImage());
+		return;
+	}
+
+	// Create image for fast pixel IO, resuming continues the last one
+	const qint32 height = size.height();
+	if (!resume) {
+		imagep_.reset(new QImage(size, QImage::Format_RGB32));
+		imagep_->fill(Qt::black);
+	}
+	const bool density = curParams_.densityMap;
+	stats_.reset(statsEnabled_ && !density ? height : 0);
+	pass_ = PASS_ITERATE;
+
+	// Custom functions replace the roots, compiled once per frame
+	expression_ = Expression::compile(curParams_.function);
+	const bool custom = !expression_.isEmpty();
+
+	// Native code once the kernel cache has it, interactive frames do not
+	// wait for the compiler but render again when it is done
+	if (custom && curParams_.nativeFunction) {
+		KernelCache &cache = KernelCache::instance();
+		expression_.setNative(bm ? cache.compile(expression_) : cache.find(expression_));
+		if (!expression_.isNative() && !bm) compileKernel();
+	}
+
+	// Root table of high degree polynomials
+	rootTable_ = !custom && curParams_.roots.count() > nf::SRC ? RootTable(curParams_.roots) : RootTable();
+
+	// Reference orbit at the view centre for deep zooms
+	const bool deep = curParams_.limits.exceedsDouble(size.width());
+	const bool perturbation = curParams_.perturbation && deep && !custom;
+	reference_ = perturbation ? ReferenceOrbit(curParams_, curParams_.limits.centerDD()) : ReferenceOrbit();
+	if (countersEnabled_) countersStart_ = PerfCounters::instance().read();
+
+	// Compute only the fundamental sector of symmetric root layouts and
+	// keep the orbits of unconverged pixels to resume them later
+	if (!resume) {
+		const bool keep = !bm && !deep && !density && !custom;
+		const bool antialias = curParams_.antiAliasing != SAMPLES_NONE && !deep && !density && !custom;
+		symmetry_ = density || custom ? Symmetry() : Symmetry(curParams_, size);
+		const bool equalize = curParams_.coloring == COLORING_EQUALIZED && !density && !custom;
+		const bool cluster = custom && !density;
+		pixels_.resize(keep || antialias || equalize || cluster || !symmetry_.isEmpty() ? size.width() * height : 0);
+		orbits_.resize(keep ? size.width() * height : 0);
+		converged_.resize(cluster ? size.width() * height : 0);
+		clusters_ = cluster ? RootClusters(height) : RootClusters();
+	}
+	iterations_ = iterations;
+	refined_ = deep ? SAMPLES_NONE : curParams_.antiAliasing;
+	stale_ = false;
+	equalized_ = false;
+	createLines(resume);
+
+	// Capped frames iterate with a copy of the params
+	if (iterations < curParams_.maxIterations) {
+		frameParams_ = curParams_;
+		frameParams_.maxIterations = iterations;
+		for (ImageLine &il : *linesp_) il.params = &frameParams_;
+	}
+
+	// Set thread count to either single or multicore
+	QThreadPool::globalInstance()->setMaxThreadCount(threadCount());
+
+	// Accumulate the orbits of the density map, one buffer per thread
+	if (density) {
+		density_ = DensityMap(iterations < curParams_.maxIterations ? frameParams_ : curParams_, size, threadCount());
+		chunks_.resize(density_.chunks());
+		for (int c = 0; c < chunks_.size(); ++c) chunks_[c] = c;
+		DensityMap *map = &density_;
+		watcher_.setFuture(QtConcurrent::map(chunks_, [map](int &chunk) { map->accumulate(chunk); }));
+		return;
+	}
+
+	// Iterate x-pixels with watcher
+	density_ = DensityMap();
+	watcher_.setFuture(QtConcurrent::map(*linesp_, iterateX));
+}
+
+void Renderer::createLines(bool resume)
+{
+	// One line per image row over the current image and pixel state
+	QImage *image = imagep_.data();
+	const int width = image->width();
+	const int height = image->height();
+	const ddouble yFactor = -curParams_.limits.heightDD() / ddouble(height - 1);
+	QVector<ImageLine> *lines = new QVector<ImageLine>(height);
+	linesp_.reset(lines);
+	for (int y = 0; y < height; ++y) {
+		ImageLine il((QRgb*)(image->scanLine(y)), y, width, &curParams_);
+		ddouble zy = curParams_.limits.topDD() + yFactor * double(y);
+		il.zy = zy.hi;
+		il.zyLo = zy.lo;
+		il.reference = reference_.isEmpty() ? nullptr : &reference_;
+		il.stats = stats_.lines.size() == height ? &stats_.lines[y] : nullptr;
+		il.pixels = pixels_.isEmpty() ? nullptr : pixels_.data() + y * width;
+		il.symmetry = symmetry_.isEmpty() ? nullptr : &symmetry_;
+		il.orbits = orbits_.isEmpty() ? nullptr : orbits_.data() + y * width;
+		il.expression = expression_.isEmpty() ? nullptr : &expression_;
+		il.converged = converged_.isEmpty() ? nullptr : converged_.data() + y * width;
+		il.rootTable = rootTable_.isEmpty() ? nullptr : &rootTable_;
+		il.resume = resume;
+		(*lines)[y] = il;
+	}
+}
+
+bool Renderer::nextPass()
+{
+	// Density maps sum the buffers of all threads, then tone map the sum
+	DensityMap *map = &density_;
+	if (!density_.isEmpty() && pass_ < PASS_DENSITY_REDUCE) {
+		pass_ = PASS_DENSITY_REDUCE;
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [map](ImageLine &il) { map->reduce(il.lineIndex); }));
+		return true;
+	}
+	if (!density_.isEmpty() && pass_ < PASS_DENSITY_TONEMAP) {
+		pass_ = PASS_DENSITY_TONEMAP;
+		density_.normalize();
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [map](ImageLine &il) { map->toneMap(il); }));
+		return true;
+	}
+
+	// Custom functions find their roots among the points pixels converged to
+	RootClusters *clusters = &clusters_;
+	if (pass_ < PASS_CLUSTER && !clusters_.isEmpty()) {
+		pass_ = PASS_CLUSTER;
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [clusters](ImageLine &il) { clusters->collect(il); }));
+		return true;
+	}
+	if (pass_ < PASS_CLASSIFY && !clusters_.isEmpty()) {
+		pass_ = PASS_CLASSIFY;
+		clusters_.merge();
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [clusters](ImageLine &il) { clusters->apply(il); }));
+		return true;
+	}
+
+	// Fill in symmetric pixels, then supersample basin boundaries
+	const Pixel *pixels = pixels_.constData();
+	if (pass_ < PASS_FILL && !symmetry_.isEmpty()) {
+		pass_ = PASS_FILL;
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [pixels](ImageLine &il) { fillX(il, pixels); }));
+		return true;
+	}
+	if (pass_ < PASS_EQUALIZE && equalizing()) {
+		equalize(pass_ < PASS_HISTOGRAM ? PASS_HISTOGRAM : PASS_EQUALIZE);
+		return true;
+	}
+	const bool deep = !linesp_->isEmpty() && curParams_.limits.exceedsDouble(linesp_->first().lineSize);
+	if (pass_ < PASS_ANTIALIAS && curParams_.antiAliasing != SAMPLES_NONE && !deep && !pixels_.isEmpty() && expression_.isEmpty()) {
+		pass_ = PASS_ANTIALIAS;
+		const int height = linesp_->size();
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [pixels, height](ImageLine &il) { antialiasX(il, pixels, height); }));
+		return true;
+	}
+	return false;
+}
+
+bool Renderer::equalizing() const
+{
+	// Equalised coloring needs the pixel state and the roots, density maps have their own
+	return curParams_.coloring == COLORING_EQUALIZED && !pixels_.isEmpty() && density_.isEmpty() && expression_.isEmpty();
+}
+
+void Renderer::equalize(RenderPass pass)
+{
+	// Count the iterations of every root, one histogram per thread
+	pass_ = pass;
+	const Pixel *pixels = pixels_.constData();
+	Equalizer *equalizer = &equalizer_;
+	if (pass == PASS_HISTOGRAM || pass == PASS_REFINE_HISTOGRAM) {
+		equalizer_ = Equalizer(curParams_, imagep_->size(), iterations_, threadCount());
+		chunks_.resize(equalizer_.chunks());
+		for (int c = 0; c < chunks_.size(); ++c) chunks_[c] = c;
+		watcher_.setFuture(QtConcurrent::map(chunks_, [equalizer, pixels](int &chunk) { equalizer->count(chunk, pixels); }));
+		return;
+	}
+
+	// Recolor every line from the summed histograms, later samples use them too
+	equalizer_.equalize();
+	equalized_ = true;
+	for (ImageLine &il : *linesp_) il.equalizer = equalizer;
+	watcher_.setFuture(QtConcurrent::map(*linesp_, [equalizer, pixels](ImageLine &il) { equalizer->apply(il, pixels); }));
+}
+
+bool Renderer::rampUp()
+{
+	// Render the view again closer to full quality while no new params wait
+	ramping_ = complete_ && curParams_.scaleDown && !curParams_.benchmark && curParams_.frameBudget > 0 &&
+		!paramsPending() && (scale_ < 1 || iterations_ < curParams_.maxIterations);
+	if (!ramping_) return false;
+	NF_TRACE_SCOPE("Renderer::rampUp", "renderer");
+	timer_.start();
+	renderFractal();
+	return true;
+}
+
+bool Renderer::refine()
+{
+	// Only complete interactive frames double can resolve, while no new params wait
+	if (!refinementEnabled_ || !complete_ || linesp_.isNull() || imagep_.isNull() || pixels_.isEmpty()) return false;
+	if (curParams_.benchmark || imagep_->size() != curParams_.size || curParams_.processor == GPU_OPENGL) return false;
+	if (curParams_.limits.exceedsDouble(imagep_->width()) || !expression_.isEmpty() || paramsPending()) return false;
+	NF_TRACE_SCOPE("Renderer::refine", "renderer");
+	const Pixel *pixels = pixels_.constData();
+	const int height = linesp_->size();
+
+	// Symmetric pixels follow every iteration pass
+	if (pass_ == PASS_REFINE_ITERATIONS && !symmetry_.isEmpty()) {
+		pass_ = PASS_REFINE_FILL;
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [pixels](ImageLine &il) { fillX(il, pixels); }));
+		return true;
+	}
+
+	// Equalise again after new iterations or a pan from the prefetch
+	if (pass_ < PASS_REFINE_EDGES && equalizing() && (!equalized_ || pass_ == PASS_REFINE_HISTOGRAM)) {
+		equalize(pass_ == PASS_REFINE_HISTOGRAM ? PASS_REFINE_EQUALIZE : PASS_REFINE_HISTOGRAM);
+		return true;
+	}
+
+	// Double the iterations of unconverged pixels up to nf::RIF times the limit
+	const int maxIterations = qMin(65535, nf::RIF * curParams_.maxIterations);
+	bool unconverged = false;
+	for (int i = 0; i < pixels_.size() && !unconverged; ++i) unconverged = pixels_[i].root < 0;
+	if (pass_ < PASS_REFINE_EDGES && unconverged && !orbits_.isEmpty() && iterations_ < maxIterations) {
+		pass_ = PASS_REFINE_ITERATIONS;
+		iterations_ = qMin(maxIterations, 2 * iterations_);
+		equalized_ = false;
+		stale_ = refined_ != SAMPLES_NONE;
+		refineParams_ = curParams_;
+		refineParams_.maxIterations = iterations_;
+		for (ImageLine &il : *linesp_) {
+			il.params = &refineParams_;
+			il.stats = nullptr;
+			il.resume = true;
+		}
+		watcher_.setFuture(QtConcurrent::map(*linesp_, iterateX));
+		return true;
+	}
+
+	// Supersample basin boundaries, denser with every pass
+	SamplePattern pattern = SAMPLES_NONE;
+	if (refined_ < SAMPLES_ROTATED4) pattern = SAMPLES_ROTATED4;
+	else if (refined_ < SAMPLES_GRID16) pattern = SAMPLES_GRID16;
+	else if (stale_) pattern = refined_;
+	if (pass_ < PASS_PREFETCH && pattern != SAMPLES_NONE) {
+		pass_ = PASS_REFINE_EDGES;
+		refined_ = pattern;
+		stale_ = false;
+		refineParams_ = curParams_;
+		refineParams_.maxIterations = iterations_;
+		refineParams_.antiAliasing = pattern;
+		for (ImageLine &il : *linesp_) il.params = &refineParams_;
+		watcher_.setFuture(QtConcurrent::map(*linesp_, [pixels, height](ImageLine &il) { antialiasX(il, pixels, height); }));
+		return true;
+	}
+
+	// Margin around the view for the next pans
+	if (!prefetched_ || curParams_.paramsChanged(prefetchBase_)) {
+		prefetch();
+		return true;
+	}
+	return false;
+}
+
+void Renderer::prefetch()
+{
+	// View extended by a margin at the same pixel spacing
+	NF_TRACE_SCOPE("Renderer::prefetch", "renderer");
+	const QSize size = imagep_->size();
+	const QPoint margin(qRound(nf::PFM * size.width()), qRound(nf::PFM * size.height()));
+	const QSize full = size + QSize(2 * margin.x(), 2 * margin.y());
+	const Limits &limits = curParams_.limits;
+	const ddouble mx = limits.widthDD() / ddouble(size.width() - 1) * double(margin.x());
+	const ddouble my = limits.heightDD() / ddouble(size.height() - 1) * double(margin.y());
+	prefetched_ = false;
+	prefetchBase_ = curParams_;
+	prefetchParams_ = curParams_;
+	prefetchParams_.size = full;
+	prefetchParams_.maxIterations = iterations_;
+	prefetchParams_.antiAliasing = SAMPLES_NONE;
+	prefetchParams_.symmetry = false;
+	prefetchParams_.limits.set(limits.leftDD() - mx, limits.rightDD() + mx, limits.topDD() + my, limits.bottomDD() - my);
+
+	// The current frame is the centre, only the margin is iterated
+	prefetchImage_ = QImage(full, QImage::Format_RGB32);
+	prefetchImage_.fill(Qt::black);
+	prefetchPixels_.resize(full.width() * full.height());
+	for (int y = 0; y < size.height(); ++y) {
+		const QRgb *src = (const QRgb*)(imagep_->constScanLine(y));
+		std::copy(src, src + size.width(), (QRgb*)(prefetchImage_.scanLine(y + margin.y())) + margin.x());
+		const Pixel *pixels = pixels_.constData() + y * size.width();
+		std::copy(pixels, pixels + size.width(), prefetchPixels_.data() + (y + margin.y()) * full.width() + margin.x());
+	}
+	const ddouble yFactor = -prefetchParams_.limits.heightDD() / ddouble(full.height() - 1);
+	prefetchLines_.clear();
+	for (int y = 0; y < full.height(); ++y) {
+		QVector<QPair<int, int>> spans;
+		if (y < margin.y() || y >= margin.y() + size.height()) {
+			spans.append(qMakePair(0, full.width()));
+		} else {
+			spans.append(qMakePair(0, margin.x()));
+			spans.append(qMakePair(margin.x() + size.width(), full.width()));
+		}
+		ddouble zy = prefetchParams_.limits.topDD() + yFactor * double(y);
+		for (const QPair<int, int> &span : spans) {
+			ImageLine il((QRgb*)(prefetchImage_.scanLine(y)) + span.first, y, full.width(), &prefetchParams_);
+			il.begin = span.first;
+			il.end = span.second;
+			il.zy = zy.hi;
+			il.zyLo = zy.lo;
+			il.pixels = prefetchPixels_.data() + y * full.width() + span.first;
+			il.equalizer = equalized_ ? &equalizer_ : nullptr;
+			il.rootTable = rootTable_.isEmpty() ? nullptr : &rootTable_;
+			prefetchLines_.append(il);
+		}
+	}
+	pass_ = PASS_PREFETCH;
+	watcher_.setFuture(QtConcurrent::map(prefetchLines_, iterateX));
+}
+
+bool Renderer::fromPrefetch()
+{
+	// Same params as the prefetch apart from a pan by whole pixels
+	if (!prefetched_ || curParams_.benchmark || curParams_.processor == GPU_OPENGL) return false;
+	Parameters same = curParams_;
+	same.limits = prefetchBase_.limits;
+	same.scaleDown = prefetchBase_.scaleDown;
+	if (same.paramsChanged(prefetchBase_)) return false;
+	const Limits &limits = curParams_.limits;
+	const Limits &base = prefetchBase_.limits;
+	if (qAbs(limits.width() - base.width()) > nf::SYT * base.width()) return false;
+	if (qAbs(limits.height() - base.height()) > nf::SYT * base.height()) return false;
+
+	// The view must lie within the margin
+	const QSize full = prefetchParams_.size;
+	const QSize size = curParams_.size;
+	const double dx = (limits.left() - prefetchParams_.limits.left()) * (full.width() - 1) / prefetchParams_.limits.width();
+	const double dy = (prefetchParams_.limits.top() - limits.top()) * (full.height() - 1) / prefetchParams_.limits.height();
+	const QPoint offset(qRound(dx), qRound(dy));
+	if (qAbs(dx - offset.x()) > 1e-3 || qAbs(dy - offset.y()) > 1e-3) return false;
+	if (!QRect(QPoint(0, 0), full).contains(QRect(offset, size))) return false;
+
+	// Copy image and pixel state, the margin has no orbits to resume
+	NF_TRACE_SCOPE("Renderer::fromPrefetch", "renderer");
+	imagep_.reset(new QImage(prefetchImage_.copy(QRect(offset, size))));
+	pixels_.resize(size.width() * size.height());
+	for (int y = 0; y < size.height(); ++y) {
+		const Pixel *src = prefetchPixels_.constData() + (y + offset.y()) * full.width() + offset.x();
+		std::copy(src, src + size.width(), pixels_.data() + y * size.width());
+	}
+	orbits_.clear();
+	symmetry_ = Symmetry();
+	reference_ = ReferenceOrbit();
+	stats_.reset(0);
+	createLines(false);
+	pass_ = PASS_ANTIALIAS;
+	complete_ = true;
+	iterations_ = prefetchParams_.maxIterations;
+	scale_ = 1;
+	refined_ = SAMPLES_NONE;
+	stale_ = false;
+	equalized_ = false;
+
+	// Emit right away and refine the new view while idle
+	fps_ = 1000.0 / qMax<qint64>(1, timer_.elapsed());
+	emit fractalRendered(imagep_->copy(), fps_);
+	refine();
+	return true;
+}
+
+void Renderer::renderOrbit()
+{
+	// One orbit at a time on the pool, requests meanwhile leave the latest
+	// params for the next one
+	if (orbitWatcher_.isRunning()) {
+		orbitStale_ = true;
+		return;
+	}
+	orbitStale_ = false;
+	orbitTimer_.start();
+	orbitWatcher_.setFuture(QtConcurrent::run(computeOrbit, curParams_));
+}
+
+void Renderer::onOrbitFinished()
+{
+	// Emit signal and continue with the latest request
+	emit orbitRendered(orbitWatcher_.result(), 1000.0 / qMax<qint64>(1, orbitTimer_.elapsed()));
+	if (orbitStale_) renderOrbit();
+}
+
+void Renderer::renderField()
+{
+	// Cached until the params change, one field at a time
+	if (!curParams_.orbitField) return;
+	if (!fieldBase_.isNull() && !fieldBase_->paramsChanged(*cur_)) return;
+	if (fieldWatcher_.isRunning()) {
+		fieldStale_ = true;
+		return;
+	}
+
+	// Rows of the grid in parallel
+	NF_TRACE_SCOPE("Renderer::renderField", "renderer");
+	fieldStale_ = false;
+	fieldBase_ = cur_;
+	field_ = OrbitField(curParams_);
+	fieldRows_.resize(field_.rows);
+	for (int row = 0; row < field_.rows; ++row) fieldRows_[row] = row;
+	OrbitField *field = &field_;
+	fieldWatcher_.setFuture(QtConcurrent::map(fieldRows_, [field](int row) { field->computeRow(row); }));
+}
+
+void Renderer::onFieldFinished()
+{
+	// Emit signal and continue with the latest params
+	if (!fieldWatcher_.isCanceled()) emit orbitFieldRendered(field_);
+	if (fieldStale_) renderField();
+}
+
+void Renderer::compileKernel()
+{
+	// One compiler run at a time, the function of the latest frame follows
+	if (kernelWatcher_.isRunning() || !KernelCache::instance().isAvailable()) return;
+	const Expression expression = expression_;
+	kernelFunction_ = expression.text();
+	kernelWatcher_.setFuture(QtConcurrent::run(&kernelPool_, [expression]() {
+		return KernelCache::instance().compile(expression);
+	}));
+}
+
+void Renderer::onKernelFinished()
+{
+	// The view moved on to another function meanwhile
+	if (expression_.text() != kernelFunction_) {
+		if (!expression_.isEmpty() && !expression_.isNative() && curParams_.nativeFunction) compileKernel();
+		return;
+	}
+
+	// Render the function again with native code, after the current frame
+	if (kernelWatcher_.result() == nullptr || expression_.isNative() || !curParams_.nativeFunction) return;
+	invalidated_ = true;
+	if (!watcher_.isRunning()) run();
+}
@@ -0,0 +1,170 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "parameters.h"
+#include "imageline.h"
+#include "perturbation.h"
+#include "renderstats.h"
+#include "symmetry.h"
+#include "framebudget.h"
+#include "snapshot.h"
+#include "orbitfield.h"
+#include "densitymap.h"
+#include "equalizer.h"
+#include "expression.h"
+#include "rootclusters.h"
+#include "roottable.h"
+#include "kernelcache.h"
+#include <QObject>
+#include <QImage>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+
+enum RenderPass {
+	PASS_ITERATE,
+	PASS_CLUSTER,
+	PASS_CLASSIFY,
+	PASS_FILL,
+	PASS_HISTOGRAM,
+	PASS_EQUALIZE,
+	PASS_ANTIALIAS,
+	PASS_DENSITY_REDUCE,
+	PASS_DENSITY_TONEMAP,
+	PASS_REFINE_ITERATIONS, // <- idle passes from here on
+	PASS_REFINE_FILL,
+	PASS_REFINE_HISTOGRAM,
+	PASS_REFINE_EQUALIZE,
+	PASS_REFINE_EDGES,
+	PASS_PREFETCH
+};
+
+// The renderer may live on a thread of its own. render() can be called from
+// any thread, everything else runs on the renderer's thread, so call the
+// slots through queued connections from elsewhere. Emitted images are copies
+// the receiver owns.
+
+class Renderer : public QObject
+{
+	Q_OBJECT
+
+public:
+	Renderer(QObject *parent = nullptr);
+	~Renderer();
+	void render(const Parameters &params);
+	uint threadCount() const;
+	bool statsEnabled() const;
+	bool countersEnabled() const;
+	bool refinementEnabled() const;
+	const FrameStats &frameStats() const;
+
+public slots:
+	void stop();
+	void invalidate();
+	void setThreadCount(uint count);
+	void setStatsEnabled(bool enabled);
+	void setCountersEnabled(bool enabled);
+	void setRefinementEnabled(bool enabled);
+	void onProgressChanged(int value);
+	void onFinished();
+
+private slots:
+	void onPublished();
+	void onOrbitFinished();
+	void onFieldFinished();
+	void onKernelFinished();
+
+protected:
+	void run();
+	void receive();
+	bool paramsPending() const;
+	bool orbitPending() const;
+	bool resumable(const Parameters &params) const;
+	bool finalFrame(const Parameters &params) const;
+	void renderFractal(bool resume = false);
+	void createLines(bool resume);
+	bool nextPass();
+	bool equalizing() const;
+	void equalize(RenderPass pass);
+	bool rampUp();
+	bool refine();
+	void prefetch();
+	bool fromPrefetch();
+	void renderOrbit();
+	void renderField();
+	void compileKernel();
+
+signals:
+	void fractalRendered(const QImage &image, double fps);
+	void orbitRendered(const QVector<QPoint> &orbit, double fps);
+	void orbitFieldRendered(const OrbitField &field);
+	void benchmarkProgress(int min, int max, int progress);
+	void benchmarkFinished(const QImage &image);
+	void statsRecorded(const FrameStats &stats);
+
+private:
+	QElapsedTimer timer_;
+	uint threadCount_;
+	bool invalidated_;
+	bool statsEnabled_;
+	bool refinementEnabled_;
+	double fps_;
+	bool countersEnabled_;
+	PerfCounts countersStart_;
+	FrameStats stats_;
+	qint64 frame_;
+	ReferenceOrbit reference_;
+	Symmetry symmetry_;
+	QVector<Pixel> pixels_;
+	QVector<complex> orbits_;
+	DensityMap density_;
+	Equalizer equalizer_;
+	Expression expression_;		// Custom f(z) of the frame, empty for the roots
+	RootClusters clusters_;
+	RootTable rootTable_;		// Roots of high degree polynomials, empty up to nf::SRC
+	QVector<complex> converged_;
+	bool equalized_;			// Image colors follow the histogram of the pixel state
+	QVector<int> chunks_;		// Chunk indices of the passes with a buffer per thread
+	RenderPass pass_;
+	bool complete_;
+	quint16 iterations_;		// Iterations the pixel state went through
+	SamplePattern refined_;		// Sample pattern of the image
+	bool stale_;				// Edges changed since the last supersampling
+	Parameters refineParams_;
+	Parameters prefetchBase_;	// View the prefetch was started from
+	Parameters prefetchParams_;	// View with margin
+	QImage prefetchImage_;
+	QVector<Pixel> prefetchPixels_;
+	QVector<ImageLine> prefetchLines_;
+	bool prefetched_;
+	FrameBudget budget_;
+	Parameters frameParams_;	// Params of a frame with capped iterations
+	double scale_;				// Scale of the image relative to the view
+	bool ramping_;				// Frame is on its way back to full quality
+	Mailbox mailbox_;
+	QAtomicInteger<quint64> generation_;	// Generation of the last published snapshot
+	QAtomicInt wakeup_;			// Wake up posted and not handled yet
+	SnapshotPtr next_;			// Latest snapshot received
+	SnapshotPtr cur_;			// Snapshot curParams_ was taken from
+	Parameters curParams_;
+	QScopedPointer<QImage> imagep_;
+	QScopedPointer<QVector<ImageLine>> linesp_;
+	QFutureWatcher<void> watcher_;
+	QFutureWatcher<QVector<QPoint>> orbitWatcher_;
+	QFutureWatcher<void> fieldWatcher_;
+	QElapsedTimer orbitTimer_;
+	bool orbitStale_;			// Orbit requested while one was computed
+	bool fieldStale_;			// Field requested while one was computed
+	SnapshotPtr fieldBase_;		// Params of the cached field
+	OrbitField field_;
+	QVector<int> fieldRows_;
+	QThreadPool kernelPool_;	// Waits for the compiler, keeps the global pool free
+	QFutureWatcher<NativeFunction> kernelWatcher_;
+	QString kernelFunction_;	// Function the compiler is working on
+};
+
+#endif // RENDERER_H
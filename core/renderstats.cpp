@@ -0,0 +1,103 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "renderstats.h"
+#include <QAtomicInt>
+#include <QHash>
+
+int statsThreadIndex()
+{
+	// Small, stable index per thread
+	static QAtomicInt counter(0);
+	thread_local int index = counter.fetchAndAddRelaxed(1);
+	return index;
+}
+
+FrameStats::FrameStats() :
+	start(0),
+	end(0)
+{
+}
+
+void FrameStats::reset(int lineCount)
+{
+	// Clear lines and restart
+	lines.fill(LineStats(), lineCount);
+	counters = PerfCounts();
+	start = statsClock();
+	end = start;
+}
+
+bool FrameStats::isEmpty() const
+{
+	// Nothing recorded
+	return lines.isEmpty();
+}
+
+qint64 FrameStats::duration() const
+{
+	// Frame duration in ns
+	return end - start;
+}
+
+quint64 FrameStats::iterations() const
+{
+	// Sum of newton iterations
+	quint64 sum = 0;
+	for (const LineStats &ls : lines) sum += ls.iterations;
+	return sum;
+}
+
+int FrameStats::pixels() const
+{
+	// Sum of pixels
+	int sum = 0;
+	for (const LineStats &ls : lines) sum += ls.pixels;
+	return sum;
+}
+
+int FrameStats::converged() const
+{
+	// Sum of converged pixels
+	int sum = 0;
+	for (const LineStats &ls : lines) sum += ls.converged;
+	return sum;
+}
+
+int FrameStats::unconverged() const
+{
+	// Sum of unconverged pixels
+	int sum = 0;
+	for (const LineStats &ls : lines) sum += ls.unconverged;
+	return sum;
+}
+
+qint64 FrameStats::slowestLine() const
+{
+	// Longest line duration in ns
+	qint64 slowest = 0;
+	for (const LineStats &ls : lines) slowest = qMax(slowest, ls.end - ls.start);
+	return slowest;
+}
+
+QVector<ThreadStats> FrameStats::threads() const
+{
+	// Aggregate lines per worker thread, times relative to frame start
+	QHash<int, int> index;
+	QVector<ThreadStats> threads;
+	for (const LineStats &ls : lines) {
+		if (ls.pixels == 0) continue;
+		if (!index.contains(ls.thread)) {
+			index.insert(ls.thread, threads.size());
+			threads.append({ls.thread, 0, 0, 0, 0});
+		}
+		ThreadStats &ts = threads[index.value(ls.thread)];
+		ts.lines++;
+		ts.busy += ls.end - ls.start;
+		ts.lastEnd = qMax(ts.lastEnd, ls.end - start);
+		ts.iterations += ls.iterations;
+	}
+	return threads;
+}
@@ -0,0 +1,66 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include "perfcounters.h"
+#include <QVector>
+#include <QMetaType>
+#include <chrono>
+
+// Recording can be compiled out with CONFIG += nostats (NF_NO_STATS).
+// When compiled in but disabled at runtime, the kernel only adds a few
+// counters per pixel and a single branch per line.
+
+inline qint64 statsClock()
+{
+	// Monotonic clock in nanoseconds
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int statsThreadIndex();
+
+struct LineStats {
+	int line;
+	int thread;
+	qint64 start;
+	qint64 end;
+	int pixels;
+	quint64 iterations;
+	int converged;
+	int unconverged;
+};
+
+struct ThreadStats {
+	int thread;
+	int lines;
+	qint64 busy;
+	qint64 lastEnd;
+	quint64 iterations;
+};
+
+struct FrameStats {
+	FrameStats();
+	void reset(int lineCount);
+	bool isEmpty() const;
+	qint64 duration() const;
+	quint64 iterations() const;
+	int pixels() const;
+	int converged() const;
+	int unconverged() const;
+	qint64 slowestLine() const;
+	QVector<ThreadStats> threads() const;
+
+	qint64 start;
+	qint64 end;
+	QVector<LineStats> lines;
+	PerfCounts counters;
+};
+
+Q_DECLARE_METATYPE(FrameStats)
+
+#endif // RENDERSTATS_H
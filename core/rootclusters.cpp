@@ -0,0 +1,104 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "rootclusters.h"
+#include "newton.h"
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+
+static void insert(QVector<complex> &points, complex z)
+{
+	// Add z unless a point within nf::CLT is known already
+	if (!std::isfinite(z.real()) || !std::isfinite(z.imag())) return;
+	for (const complex &p : points) {
+		if (norm(p - z) < nf::CLT * nf::CLT) return;
+	}
+	points.append(z);
+}
+
+RootClusters::RootClusters()
+{
+}
+
+RootClusters::RootClusters(int lines) :
+	lines_(lines)
+{
+}
+
+bool RootClusters::isEmpty() const
+{
+	// No lines to collect from
+	return lines_.isEmpty();
+}
+
+void RootClusters::collect(const ImageLine &il)
+{
+	// Distinct points of a line, there are few roots per line
+	QVector<complex> &points = lines_[il.lineIndex];
+	points.clear();
+	if (il.converged == nullptr) return;
+	for (int x = il.begin; x < il.end; ++x) insert(points, il.converged[x - il.begin]);
+}
+
+void RootClusters::merge()
+{
+	// Merge the points of all lines, sorted so indices do not depend on threads
+	roots_.clear();
+	for (const QVector<complex> &points : lines_) {
+		for (const complex &z : points) insert(roots_, z);
+	}
+	std::sort(roots_.begin(), roots_.end(), [](const complex &a, const complex &b) {
+		return a.real() < b.real() || (a.real() == b.real() && a.imag() < b.imag());
+	});
+	if (roots_.size() > nf::MRC) roots_.resize(nf::MRC);
+
+	// Color by position on a grid of nf::CLT
+	colors_.clear();
+	for (const complex &z : roots_) {
+		const uint cell = qHash(qint64(std::floor(z.real() / nf::CLT)), qHash(qint64(std::floor(z.imag() / nf::CLT))));
+		colors_.append(nf::predefColors[cell % nf::PCC]);
+	}
+}
+
+void RootClusters::apply(ImageLine &il) const
+{
+	// Root index and color of every computed pixel of a line
+	if (il.converged == nullptr || il.pixels == nullptr) return;
+	for (int x = il.begin; x < il.end; ++x) {
+		Pixel &pixel = il.pixels[x - il.begin];
+		const int root = find(il.converged[x - il.begin]);
+		pixel.root = root;
+		if (root >= 0) il.scanLine[x - il.begin] = shadeColor(colors_[root], *il.params, pixel.iteration, pixel.fraction());
+	}
+}
+
+int RootClusters::count() const
+{
+	// Number of roots found
+	return roots_.size();
+}
+
+complex RootClusters::root(int index) const
+{
+	// Position of a root
+	return roots_[index];
+}
+
+int RootClusters::find(complex z) const
+{
+	// Nearest root within nf::CLT, -1 if none
+	if (!std::isfinite(z.real()) || !std::isfinite(z.imag())) return -1;
+	int nearest = -1;
+	double best = nf::CLT * nf::CLT;
+	for (int k = 0; k < roots_.size(); ++k) {
+		const double distance = norm(roots_[k] - z);
+		if (distance < best) {
+			best = distance;
+			nearest = k;
+		}
+	}
+	return nearest;
+}
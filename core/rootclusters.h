@@ -0,0 +1,39 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef ROOTCLUSTERS_H
+#define ROOTCLUSTERS_H
+
+#include "imageline.h"
+#include <QColor>
+
+// Roots of a custom f(z), found among the points its pixels converged to.
+// Every line collects its distinct points in parallel, points closer than
+// nf::CLT belong to the same root. The points of all lines are then merged
+// and sorted, and every pixel gets the index of its root and a color. Colors
+// follow the position of the root, so they stay put while panning. Up to
+// nf::MRC roots per frame, pixels of further roots stay black.
+
+class RootClusters
+{
+public:
+	RootClusters();
+	RootClusters(int lines);
+	bool isEmpty() const;
+	void collect(const ImageLine &il);
+	void merge();
+	void apply(ImageLine &il) const;
+	int count() const;
+	complex root(int index) const;
+
+private:
+	int find(complex z) const;
+
+	QVector<QVector<complex>> lines_;	// Distinct points of every line
+	QVector<complex> roots_;
+	QVector<QColor> colors_;
+};
+
+#endif // ROOTCLUSTERS_H
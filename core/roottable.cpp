@@ -0,0 +1,123 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "roottable.h"
+#include <cmath>
+
+RootTable::RootTable() :
+	left_(0),
+	bottom_(0),
+	cell_(1),
+	columns_(0),
+	rows_(0)
+{
+}
+
+RootTable::RootTable(const QVector<Root> &roots) :
+	RootTable()
+{
+	// Coordinates apart for the lanes
+	const int rootCount = roots.count();
+	if (rootCount == 0) return;
+	x_.resize(rootCount);
+	y_.resize(rootCount);
+	for (int k = 0; k < rootCount; ++k) {
+		x_[k] = roots[k].value().real();
+		y_[k] = roots[k].value().imag();
+	}
+
+	// Bounding box with a margin of nf::EPS
+	double left = x_[0], right = x_[0], bottom = y_[0], top = y_[0];
+	for (int k = 1; k < rootCount; ++k) {
+		left = qMin(left, x_[k]);
+		right = qMax(right, x_[k]);
+		bottom = qMin(bottom, y_[k]);
+		top = qMax(top, y_[k]);
+	}
+	left_ = left - nf::EPS;
+	bottom_ = bottom - nf::EPS;
+	const double width = right + nf::EPS - left_;
+	const double height = top + nf::EPS - bottom_;
+
+	// About one root per cell, roots on a line still spread over n cells
+	cell_ = qMax(qMax(std::sqrt(width * height / rootCount), qMax(width, height) / rootCount), nf::EPS);
+	columns_ = qMax(1, int(std::ceil(width / cell_)));
+	rows_ = qMax(1, int(std::ceil(height / cell_)));
+
+	// Count roots per cell, then sort their indices by cell
+	QVector<int> index(rootCount);
+	cells_.fill(0, columns_ * rows_ + 1);
+	for (int k = 0; k < rootCount; ++k) {
+		const int cx = qBound(0, int((x_[k] - left_) / cell_), columns_ - 1);
+		const int cy = qBound(0, int((y_[k] - bottom_) / cell_), rows_ - 1);
+		index[k] = cy * columns_ + cx;
+		cells_[index[k] + 1]++;
+	}
+	for (int c = 0; c < columns_ * rows_; ++c) cells_[c + 1] += cells_[c];
+	QVector<int> next = cells_;
+	cellRoots_.resize(rootCount);
+	for (int k = 0; k < rootCount; ++k) cellRoots_[next[index[k]]++] = k;
+}
+
+bool RootTable::isEmpty() const
+{
+	// No roots
+	return x_.isEmpty();
+}
+
+int RootTable::count() const
+{
+	// Number of roots
+	return x_.size();
+}
+
+void RootTable::quotient(const double *x, const double *y, double *qr, double *qi) const
+{
+	// Sum 1 / (z - r_k) root by root over all lanes, a lane on a root steps 0
+	double sr[nf::FLN] = {}, si[nf::FLN] = {}, hit[nf::FLN] = {};
+	const int rootCount = x_.size();
+	for (int k = 0; k < rootCount; ++k) {
+		const double rx = x_[k], ry = y_[k];
+		for (int l = 0; l < nf::FLN; ++l) {
+			const double wx = x[l] - rx, wy = y[l] - ry;
+			const double n = wx * wx + wy * wy;
+			const double inv = n > 0 ? 1 / n : 0;
+			sr[l] += wx * inv;
+			si[l] -= wy * inv;
+			hit[l] = n > 0 ? hit[l] : 1;
+		}
+	}
+
+	// f / f' is the inverse of the sum
+	for (int l = 0; l < nf::FLN; ++l) {
+		const double inv = hit[l] > 0 ? 0 : 1 / (sr[l] * sr[l] + si[l] * si[l]);
+		qr[l] = sr[l] * inv;
+		qi[l] = -si[l] * inv;
+	}
+}
+
+int RootTable::find(double x, double y) const
+{
+	// Lowest root index within nf::EPS, -1 if none
+	if (isEmpty() || !std::isfinite(x) || !std::isfinite(y)) return -1;
+	const double fx = std::floor((x - left_) / cell_);
+	const double fy = std::floor((y - bottom_) / cell_);
+	if (fx < -1 || fy < -1 || fx > columns_ || fy > rows_) return -1;
+
+	// Only the neighbouring cells can hold roots that close
+	const int cx = int(fx), cy = int(fy);
+	int found = -1;
+	for (int j = qMax(0, cy - 1); j <= qMin(rows_ - 1, cy + 1); ++j) {
+		for (int i = qMax(0, cx - 1); i <= qMin(columns_ - 1, cx + 1); ++i) {
+			const int c = j * columns_ + i;
+			for (int n = cells_[c]; n < cells_[c + 1]; ++n) {
+				const int k = cellRoots_[n];
+				const double dx = x - x_[k], dy = y - y_[k];
+				if (dx * dx + dy * dy < nf::EPS * nf::EPS && (found < 0 || k < found)) found = k;
+			}
+		}
+	}
+	return found;
+}
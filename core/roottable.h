@@ -0,0 +1,40 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef ROOTTABLE_H
+#define ROOTTABLE_H
+
+#include "parameters.h"
+
+// Roots of a polynomial of high degree, built once per frame. The newton
+// step uses the log-derivative f' / f = sum 1 / (z - r_k) over coordinates
+// stored apart, so the loop over the roots vectorizes across nf::FLN lanes
+// and never over- or underflows like the product of many roots. Converged
+// points find their root through a grid of cells at least nf::EPS wide,
+// only the 3x3 cells around a point can hold roots within nf::EPS.
+
+class RootTable
+{
+public:
+	RootTable();
+	RootTable(const QVector<Root> &roots);
+	bool isEmpty() const;
+	int count() const;
+	void quotient(const double *x, const double *y, double *qr, double *qi) const;
+	int find(double x, double y) const;
+
+private:
+	QVector<double> x_;
+	QVector<double> y_;
+	double left_;
+	double bottom_;
+	double cell_;
+	int columns_;
+	int rows_;
+	QVector<int> cells_;		// Start of every cell in cellRoots_, one more at the end
+	QVector<int> cellRoots_;	// Root indices sorted by cell
+};
+
+#endif // ROOTTABLE_H
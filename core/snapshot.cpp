@@ -0,0 +1,56 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "snapshot.h"
+
+Snapshot::Snapshot(const Parameters &params, quint64 generation) :
+	params(params),
+	generation(generation),
+	hash(params.hash())
+{
+}
+
+bool Snapshot::paramsChanged(const Snapshot &other) const
+{
+	// Compare fields only if the hashes cannot tell
+	if (generation == other.generation) return false;
+	if (hash != other.hash) return true;
+	return params.paramsChanged(other.params);
+}
+
+bool Snapshot::orbitChanged(const Snapshot &other) const
+{
+	// Check for orbit, same as Parameters::orbitChanged
+	return (
+		params.orbitStart != other.params.orbitStart ||
+		params.orbitMode != other.params.orbitMode ||
+		params.orbitField != other.params.orbitField ||
+		((params.orbitMode || params.orbitField) && paramsChanged(other))
+	);
+}
+
+Mailbox::Mailbox() :
+	slot_(nullptr)
+{
+}
+
+Mailbox::~Mailbox()
+{
+	// Delete a snapshot nobody took
+	delete slot_.fetchAndStoreAcquire(nullptr);
+}
+
+void Mailbox::publish(const SnapshotPtr &snapshot)
+{
+	// Swap in the new snapshot and drop the one it replaces
+	delete slot_.fetchAndStoreOrdered(new SnapshotPtr(snapshot));
+}
+
+SnapshotPtr Mailbox::take()
+{
+	// Empty the slot, null if nothing was published since the last take
+	QScopedPointer<SnapshotPtr> taken(slot_.fetchAndStoreOrdered(nullptr));
+	return taken.isNull() ? SnapshotPtr() : *taken;
+}
@@ -0,0 +1,46 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "parameters.h"
+#include <QSharedPointer>
+#include <QAtomicPointer>
+
+// Immutable params handed from the GUI to the renderer. Snapshots of the
+// same generation are equal and different hashes mean changed params, only
+// equal hashes of different generations are compared field by field.
+
+struct Snapshot {
+	Snapshot(const Parameters &params, quint64 generation);
+	bool paramsChanged(const Snapshot &other) const;
+	bool orbitChanged(const Snapshot &other) const;
+
+	const Parameters params;
+	const quint64 generation;
+	const uint hash; // <- Parameters::hash()
+};
+
+typedef QSharedPointer<const Snapshot> SnapshotPtr;
+
+// Single slot between one publishing and one receiving thread. Publishing
+// replaces a snapshot nobody took yet, so the receiver only ever sees the
+// latest one. Both sides swap the slot atomically and never lock.
+
+class Mailbox
+{
+public:
+	Mailbox();
+	~Mailbox();
+	void publish(const SnapshotPtr &snapshot);
+	SnapshotPtr take();
+
+private:
+	Q_DISABLE_COPY(Mailbox)
+	QAtomicPointer<SnapshotPtr> slot_;
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,218 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "symmetry.h"
+
+static bool matchRoots(const Parameters &params, const QVector<complex> &image, double tolerance, QVector<qint16> &match)
+{
+	// Map every root onto the root at its image, fails unless a permutation
+	const int rootCount = params.roots.count();
+	QVector<bool> hit(rootCount, false);
+	match.fill(-1, rootCount);
+	for (int k = 0; k < rootCount; ++k) {
+		for (int j = 0; j < rootCount; ++j) {
+			if (!hit[j] && abs(image[k] - params.roots[j].value()) < tolerance) {
+				match[k] = j;
+				hit[j] = true;
+				break;
+			}
+		}
+		if (match[k] < 0) return false;
+	}
+	return true;
+}
+
+Symmetry::Symmetry() :
+	order_(0),
+	mirror_(false),
+	keepUpper_(true),
+	axis_(0),
+	rootCount_(0),
+	width_(0),
+	height_(0),
+	left_(0),
+	top_(0),
+	xFactor_(0),
+	yFactor_(0)
+{
+}
+
+Symmetry::Symmetry(const Parameters &params, QSize size) :
+	Symmetry()
+{
+	// Only for views double can resolve
+	const int rootCount = params.roots.count();
+	if (!params.symmetry || rootCount < 2 || size.width() < 2 || size.height() < 2) return;
+	if (params.limits.exceedsDouble(size.width())) return;
+
+	// Turn about the centroid of the roots
+	complex center(0, 0);
+	for (const Root &root : params.roots) center += root.value();
+	center /= double(rootCount);
+	double radius = 0;
+	for (const Root &root : params.roots) radius = qMax(radius, abs(root.value() - center));
+	if (radius == 0) return;
+	const double tolerance = nf::SYT * radius;
+	center_ = center;
+	rootCount_ = rootCount;
+
+	// Highest order whose turn maps the root set onto itself
+	QVector<complex> image(rootCount);
+	QVector<qint16> turn;
+	for (int order = rootCount; order >= 2; --order) {
+		const complex edge = std::polar(1.0, 2 * nf::PI / order);
+		for (int k = 0; k < rootCount; ++k) image[k] = center + edge * (params.roots[k].value() - center);
+		if (!matchRoots(params, image, tolerance, turn)) continue;
+
+		// Root permutation for every number of turns
+		roots_.resize(order * rootCount);
+		for (int k = 0; k < rootCount; ++k) roots_[k] = k;
+		for (int t = 1; t < order; ++t) {
+			for (int k = 0; k < rootCount; ++k) {
+				roots_[t * rootCount + k] = turn[roots_[(t - 1) * rootCount + k]];
+			}
+		}
+		order_ = order;
+		edge_ = edge;
+		back_ = conj(edge);
+		break;
+	}
+
+	// Pixel grid of the frame
+	const double top = params.limits.top();
+	const double bottom = params.limits.bottom();
+	width_ = size.width();
+	height_ = size.height();
+	left_ = params.limits.left();
+	top_ = top;
+	xFactor_ = params.limits.width() / (width_ - 1);
+	yFactor_ = -params.limits.height() / (height_ - 1);
+
+	// Mirror on the horizontal axis through the centroid, needs real damping
+	// and the axis in view on a row or halfway between two rows
+	axis_ = center.imag();
+	const double rows = 2 * (axis_ - top_) / yFactor_;
+	if (params.damping.imag() == 0 && bottom < axis_ && axis_ < top && qAbs(rows - qRound(rows)) < nf::SYP) {
+		for (int k = 0; k < rootCount; ++k) {
+			complex z = params.roots[k].value();
+			image[k] = complex(z.real(), 2 * axis_ - z.imag());
+		}
+		mirror_ = matchRoots(params, image, tolerance, mirrored_);
+		keepUpper_ = top - axis_ >= axis_ - bottom;
+	}
+}
+
+bool Symmetry::isEmpty() const
+{
+	// Neither turn nor mirror found
+	return order_ < 2 && !mirror_;
+}
+
+int Symmetry::order() const
+{
+	// Number of sectors, 0 without rotational symmetry
+	return order_;
+}
+
+bool Symmetry::mirror() const
+{
+	// Return if one half mirrors the other
+	return mirror_;
+}
+
+complex Symmetry::center() const
+{
+	// Centre of the turn
+	return center_;
+}
+
+int Symmetry::source(int x, int y, int &turns, bool &mirrored) const
+{
+	// Pixel index to copy from, -1 if the pixel has to be computed
+	turns = 0;
+	mirrored = false;
+	if (isEmpty()) return -1;
+
+	// Turn first, the fundamental sector always computes itself
+	if (order_ >= 2) {
+		complex w = pixel2complex(x, y) - center_;
+		if (inSector(w)) return -1;
+		int index = turned(w, turns);
+		if (index >= 0) return index;
+		turns = 0;
+	}
+
+	// Mirror what is left from a pixel the turn does not fill either
+	int row = mirrorRow(y);
+	if (row < 0) return -1;
+	if (order_ >= 2) {
+		complex w = pixel2complex(x, row) - center_;
+		int t;
+		if (!inSector(w) && turned(w, t) >= 0) return -1;
+	}
+	mirrored = true;
+	return row * width_ + x;
+}
+
+int Symmetry::permute(int root, int turns, bool mirrored) const
+{
+	// Root a pixel converges to after turning or mirroring it
+	if (root < 0 || isEmpty()) return root;
+	if (mirrored) return mirrored_[root];
+	if (order_ < 2) return root;
+	return roots_[turns % order_ * rootCount_ + root];
+}
+
+complex Symmetry::pixel2complex(int x, int y) const
+{
+	// Same mapping as iterateX
+	return complex(x * xFactor_ + left_, y * yFactor_ + top_);
+}
+
+bool Symmetry::inSector(complex w) const
+{
+	// Angle in [0, 2 pi / order), the sector of order 2 is the upper half plane
+	if (order_ == 2) return w.imag() > 0 || (w.imag() == 0 && w.real() > 0);
+	return w.imag() >= 0 && edge_.real() * w.imag() - edge_.imag() * w.real() < 0;
+}
+
+int Symmetry::turned(complex w, int &turns) const
+{
+	// Turn back sector by sector into the fundamental one
+	for (turns = 1; turns < order_; ++turns) {
+		w *= back_;
+		if (!inSector(w)) continue;
+
+		// Counterpart must be a pixel of the image that computes itself
+		complex s = center_ + w;
+		const double fx = (s.real() - left_) / xFactor_;
+		const double fy = (s.imag() - top_) / yFactor_;
+		int sx = qRound(fx);
+		int sy = qRound(fy);
+		if (qAbs(fx - sx) >= nf::SYP || qAbs(fy - sy) >= nf::SYP) return -1;
+		if (sx < 0 || sy < 0 || sx >= width_ || sy >= height_) return -1;
+		if (!inSector(pixel2complex(sx, sy) - center_)) return -1;
+		return sy * width_ + sx;
+	}
+
+	// Rounding put w on a sector edge
+	return -1;
+}
+
+int Symmetry::mirrorRow(int y) const
+{
+	// Row of the kept half to mirror from, -1 if y is kept itself
+	if (!mirror_) return -1;
+	const double zy = y * yFactor_ + top_;
+	if (keepUpper_ ? zy >= axis_ : zy <= axis_) return -1;
+
+	// The axis lies on the grid, so the mirrored row is exact. It must lie
+	// in the image and on the kept side.
+	int row = qRound((2 * axis_ - zy - top_) / yFactor_);
+	if (row < 0 || row >= height_) return -1;
+	const double zr = row * yFactor_ + top_;
+	if (keepUpper_ ? zr < axis_ : zr > axis_) return -1;
+	return row;
+}
@@ -0,0 +1,64 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "parameters.h"
+
+// Rotational symmetry of the root layout. If turning every root by 2 pi / order
+// about center gives the same root set, f only changes by a constant factor
+// and the newton map commutes with the turn, whatever the damping. A pixel then
+// takes as many iterations as its turned counterpart and converges to the
+// turned root. Only the fundamental sector [0, 2 pi / order) is computed, the
+// other pixels copy their counterpart in that sector and permute its root.
+// A pixel is only copied if its counterpart lies on the pixel grid within
+// nf::SYP, otherwise it is computed. Turns by other than 90 or 180 degrees
+// hardly ever hit the grid.
+//
+// Root sets closed under mirroring on the horizontal axis through their
+// centroid (complex conjugation for roots symmetric to the real axis) give a
+// mirror symmetric fractal if the damping is real. If the axis lies in the
+// view on a row or halfway between two rows, the smaller half copies the rows
+// of the larger one. The turn takes precedence, mirroring only fills pixels
+// the turn cannot.
+
+class Symmetry
+{
+public:
+	Symmetry();
+	Symmetry(const Parameters &params, QSize size);
+	bool isEmpty() const;
+	int order() const;
+	bool mirror() const;
+	complex center() const;
+	int source(int x, int y, int &turns, bool &mirrored) const;
+	int permute(int root, int turns, bool mirrored) const;
+
+private:
+	complex pixel2complex(int x, int y) const;
+	bool inSector(complex w) const;
+	int turned(complex w, int &turns) const;
+	int mirrorRow(int y) const;
+
+	int order_;
+	complex center_;
+	complex edge_;				// End of the fundamental sector, e^(2 pi i / order)
+	complex back_;				// One turn backwards, conj(edge_)
+	QVector<qint16> roots_;		// Root index after turns, rootCount per turn
+	bool mirror_;
+	bool keepUpper_;			// Compute the half above the axis
+	double axis_;				// Imaginary part of the mirror axis
+	QVector<qint16> mirrored_;	// Root index after mirroring
+	int rootCount_;
+	int width_;
+	int height_;
+	double left_;
+	double top_;
+	double xFactor_;
+	double yFactor_;
+};
+
+#endif // SYMMETRY_H
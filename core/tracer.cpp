@@ -0,0 +1,138 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#include "tracer.h"
+#include "renderstats.h"
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QThread>
+#include <QFile>
+
+Tracer &Tracer::instance()
+{
+	// Process wide tracer
+	static Tracer tracer;
+	return tracer;
+}
+
+Tracer::Tracer() :
+	enabled_(false),
+	origin_(0)
+{
+}
+
+bool Tracer::start(const QString &fileName)
+{
+	// Start collecting, file is written on stop
+	QMutexLocker locker(&mutex_);
+	fileName_ = fileName;
+	origin_ = statsClock();
+	events_.clear();
+	events_.reserve(1 << 16);
+	enabled_.store(true);
+	return true;
+}
+
+bool Tracer::stop()
+{
+	// Stop collecting
+	if (!enabled_.exchange(false)) return false;
+	QMutexLocker locker(&mutex_);
+	QFile file(fileName_);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	// Write trace events, timestamps are in microseconds
+	QTextStream out(&file);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (auto it = threadNames_.constBegin(); it != threadNames_.constEnd(); ++it) {
+		out << (first ? "" : ",\n")
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it.key()
+			<< ",\"args\":{\"name\":\"" << it.value() << "\"}}";
+		first = false;
+	}
+	for (const TraceEvent &e : events_) {
+		out << (first ? "" : ",\n")
+			<< "{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category
+			<< "\",\"ph\":\"" << e.phase << "\",\"pid\":1,\"tid\":" << e.thread
+			<< ",\"ts\":" << QString::number(e.start / 1000.0, 'f', 3);
+		if (e.phase == 'X') out << ",\"dur\":" << QString::number(e.duration / 1000.0, 'f', 3);
+		if (e.phase == 'b' || e.phase == 'e') out << ",\"id\":" << e.id;
+		if (e.phase == 'i') out << ",\"s\":\"t\"";
+		if (e.arg >= 0) out << ",\"args\":{\"value\":" << e.arg << "}";
+		out << "}";
+		first = false;
+	}
+	out << "\n]}\n";
+	events_.clear();
+	return true;
+}
+
+void Tracer::complete(const char *name, const char *category, qint64 start, qint64 end, qint64 arg)
+{
+	// Span with duration
+	if (!isEnabled()) return;
+	add({name, category, 'X', thread(), start - origin_, end - start, 0, arg});
+}
+
+void Tracer::asyncBegin(const char *name, const char *category, qint64 id)
+{
+	// Start of a span that may cross threads or overlap others
+	if (!isEnabled()) return;
+	add({name, category, 'b', thread(), statsClock() - origin_, 0, id, -1});
+}
+
+void Tracer::asyncEnd(const char *name, const char *category, qint64 id)
+{
+	// End of an async span
+	if (!isEnabled()) return;
+	add({name, category, 'e', thread(), statsClock() - origin_, 0, id, -1});
+}
+
+void Tracer::instant(const char *name, const char *category)
+{
+	// Point in time
+	if (!isEnabled()) return;
+	add({name, category, 'i', thread(), statsClock() - origin_, 0, 0, -1});
+}
+
+void Tracer::add(const TraceEvent &event)
+{
+	// Append event
+	QMutexLocker locker(&mutex_);
+	events_.append(event);
+}
+
+int Tracer::thread()
+{
+	// Name threads on first use
+	thread_local bool named = false;
+	int index = statsThreadIndex();
+	if (!named) {
+		QCoreApplication *app = QCoreApplication::instance();
+		bool main = app != nullptr && app->thread() == QThread::currentThread();
+		QMutexLocker locker(&mutex_);
+		threadNames_.insert(index, main ? QString("main") : QString("worker %1").arg(index));
+		named = true;
+	}
+	return index;
+}
+
+TraceSpan::TraceSpan(const char *name, const char *category, qint64 arg) :
+	name_(name),
+	category_(category),
+	start_(Tracer::instance().isEnabled() ? statsClock() : 0),
+	arg_(arg)
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+	// Record span if tracing
+	if (start_ != 0) {
+		Tracer::instance().complete(name_, category_, start_, statsClock(), arg_);
+	}
+}
@@ -0,0 +1,78 @@
+// This file is part of the NewtonFractal project.
+// Copyright (C) 2019 Christian Bauer and Timon Foehl
+// License: GNU General Public License version 3 or later,
+// see the file LICENSE in the main directory.
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// Collects spans and writes them as Chrome trace event JSON, which can be
+// loaded in chrome://tracing or https://ui.perfetto.dev. Tracing is opt-in,
+// a disabled tracer costs a single relaxed atomic load per span and
+// CONFIG += notrace (NF_NO_TRACE) compiles all spans out.
+
+struct TraceEvent {
+	const char *name;
+	const char *category;
+	char phase;
+	int thread;
+	qint64 start;
+	qint64 duration;
+	qint64 id;
+	qint64 arg;
+};
+
+class Tracer
+{
+public:
+	static Tracer &instance();
+	bool start(const QString &fileName);
+	bool stop();
+	bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+	void complete(const char *name, const char *category, qint64 start, qint64 end, qint64 arg = -1);
+	void asyncBegin(const char *name, const char *category, qint64 id);
+	void asyncEnd(const char *name, const char *category, qint64 id);
+	void instant(const char *name, const char *category);
+
+protected:
+	Tracer();
+	void add(const TraceEvent &event);
+	int thread();
+
+private:
+	std::atomic<bool> enabled_;
+	QMutex mutex_;
+	QString fileName_;
+	qint64 origin_;
+	QVector<TraceEvent> events_;
+	QHash<int, QString> threadNames_;
+};
+
+class TraceSpan
+{
+public:
+	TraceSpan(const char *name, const char *category, qint64 arg = -1);
+	~TraceSpan();
+
+private:
+	const char *name_;
+	const char *category_;
+	qint64 start_;
+	qint64 arg_;
+};
+
+#ifndef NF_NO_TRACE
+#define NF_TRACE_CONCAT_(a, b) a##b
+#define NF_TRACE_CONCAT(a, b) NF_TRACE_CONCAT_(a, b)
+#define NF_TRACE_SCOPE(...) TraceSpan NF_TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+#else
+#define NF_TRACE_SCOPE(...)
+#endif
+
+#endif // TRACER_H
@@ -6,7 +6,9 @@
 #include "fractalwidget.h"
 #include "settingswidget.h"
 #include "parameters.h"
+#include "tracer.h"
 #include <QApplication>
+#include <QScreen>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QMouseEvent>
@@ -34,9 +36,13 @@ FractalWidget::FractalWidget(QWidget *parent) :
 	enabled_(true),
 	params_(new Parameters()),
 	settingsWidget_(new SettingsWidget(params_, this)),
+	renderer_(new Renderer()),
 	fps_(0),
+	scale_(1),
 	legend_(true),
-	position_(false)
+	position_(false),
+	overlay_(false),
+	renderPending_(false)
 {
 	// Initialize layout
 	QSpacerItem *spacer = new QSpacerItem(nf::DSI / 2.0, 20, QSizePolicy::Expanding, QSizePolicy::Minimum);
@@ -54,16 +60,48 @@ FractalWidget::FractalWidget(QWidget *parent) :
 	setWindowIcon(QIcon("://resources/icons/icon.png"));
 	scaleDownTimer_.setInterval(nf::DTI);
 	scaleDownTimer_.setSingleShot(true);
+	QScreen *screen = QApplication::primaryScreen();
+	double refreshRate = screen != nullptr && screen->refreshRate() > 0 ? screen->refreshRate() : nf::DRR;
+	frameTimer_.setInterval(qMax(1, qRound(1000 / refreshRate)));
+	frameTimer_.setTimerType(Qt::PreciseTimer);
+	frameTimer_.setSingleShot(true);
 	resize(params_->size);
 	settingsWidget_->hide();
+	renderer_->setRefinementEnabled(true);
+
+	// Run the renderer on its own thread, only finished frames come back
+	renderer_->moveToThread(&renderThread_);
+	connect(&renderThread_, &QThread::finished, renderer_, &QObject::deleteLater);
+	renderThread_.start();
 
 	// Connect new shortcut signals
 	connect(newSC("Ctrl+Q"), &QShortcut::activated, QApplication::instance(), &QCoreApplication::quit);
 	connect(newSC(Qt::Key_Escape), &QShortcut::activated, [this]() { legend_ = !legend_; update(); });
 	connect(newSC(Qt::Key_F2), &QShortcut::activated, [this]() { params_->orbitMode = !params_->orbitMode; updateParams(); });
 	connect(newSC(Qt::Key_F3), &QShortcut::activated, [this]() { position_ = !position_; update(); });
+	connect(newSC(Qt::Key_F4), &QShortcut::activated, [this]() {
+		overlay_ = !overlay_;
+		QMetaObject::invokeMethod(renderer_, "setStatsEnabled", Qt::QueuedConnection, Q_ARG(bool, overlay_));
+		QMetaObject::invokeMethod(renderer_, "setCountersEnabled", Qt::QueuedConnection, Q_ARG(bool, overlay_));
+		updateParams();
+		update();
+	});
+	connect(newSC(Qt::Key_F5), &QShortcut::activated, [this]() {
+		params_->antiAliasing = static_cast<SamplePattern>((params_->antiAliasing + 1) % (SAMPLES_GRID16 + 1));
+		updateParams();
+		update();
+	});
+	connect(newSC(Qt::Key_F6), &QShortcut::activated, [this]() { params_->orbitField = !params_->orbitField; updateParams(); update(); });
+	connect(newSC(Qt::Key_F7), &QShortcut::activated, [this]() { params_->densityMap = !params_->densityMap; updateParams(); });
+	connect(newSC(Qt::Key_F8), &QShortcut::activated, [this]() {
+		params_->coloring = static_cast<Coloring>((params_->coloring + 1) % (COLORING_SMOOTH + 1));
+		updateParams();
+		update();
+	});
+	connect(newSC(Qt::Key_F9), &QShortcut::activated, [this]() { params_->nativeFunction = !params_->nativeFunction; updateParams(); });
 	connect(newSC(Qt::Key_F1), &QShortcut::activated, settingsWidget_, &SettingsWidget::toggle);
 	connect(newSC("Ctrl+R"), &QShortcut::activated, settingsWidget_, &SettingsWidget::reset);
+	connect(newSC("Ctrl+Shift+R"), &QShortcut::activated, this, &FractalWidget::randomize);
 	connect(newSC("Ctrl+S"), &QShortcut::activated, settingsWidget_, &SettingsWidget::exportImage);
 	connect(newSC("Ctrl+E"), &QShortcut::activated, settingsWidget_, &SettingsWidget::exportSettings);
 	connect(newSC("Ctrl+I"), &QShortcut::activated, settingsWidget_, &SettingsWidget::importSettings);
@@ -75,18 +113,25 @@ FractalWidget::FractalWidget(QWidget *parent) :
 	connect(settingsWidget_, &SettingsWidget::reset, this, &FractalWidget::reset);
 
 	// Connect renderthread and timer signals
-	connect(&renderer_, &Renderer::fractalRendered, this, &FractalWidget::updateFractal);
-	connect(&renderer_, &Renderer::orbitRendered, this, &FractalWidget::updateOrbit);
+	connect(renderer_, &Renderer::fractalRendered, this, &FractalWidget::updateFractal);
+	connect(renderer_, &Renderer::orbitRendered, this, &FractalWidget::updateOrbit);
+	connect(renderer_, &Renderer::orbitFieldRendered, this, &FractalWidget::updateOrbitField);
+	connect(renderer_, &Renderer::statsRecorded, this, &FractalWidget::updateStats);
 	connect(&scaleDownTimer_, &QTimer::timeout, [this]() {
 		params_->scaleDown = false;
 		updateParams();
 	});
+	connect(&frameTimer_, &QTimer::timeout, [this]() {
+		if (!renderPending_) return;
+		renderPending_ = false;
+		updateParams();
+	});
 
 	// Connect benchmark signals
 	connect(settingsWidget_, &SettingsWidget::startBenchmarkRequested, this, &FractalWidget::runBenchmark);
-	connect(settingsWidget_, &SettingsWidget::stopBenchmarkRequested, &renderer_, &Renderer::stop);
-	connect(&renderer_, &Renderer::benchmarkFinished, this, &FractalWidget::finishBenchmark);
-	connect(&renderer_, &Renderer::benchmarkProgress, settingsWidget_, &SettingsWidget::setBenchmarkProgress);
+	connect(settingsWidget_, &SettingsWidget::stopBenchmarkRequested, renderer_, &Renderer::stop);
+	connect(renderer_, &Renderer::benchmarkFinished, this, &FractalWidget::finishBenchmark);
+	connect(renderer_, &Renderer::benchmarkProgress, settingsWidget_, &SettingsWidget::setBenchmarkProgress);
 
 	// Initialize parameters
 	reset();
@@ -94,6 +139,10 @@ FractalWidget::FractalWidget(QWidget *parent) :
 
 FractalWidget::~FractalWidget()
 {
+	// Stop the render thread, it deletes the renderer on its way out
+	renderThread_.quit();
+	renderThread_.wait();
+
 	// Delete params only -> other pointers are being handled by Qt
 	// TODO: Use QSharedPointer for params
 	delete params_;
@@ -101,10 +150,17 @@ FractalWidget::~FractalWidget()
 
 void FractalWidget::updateParams()
 {
-	// Pass params to renderthread by const reference
-	if (enabled_) {
-		renderer_.render(*params_);
+	// Pass params to renderthread by const reference, at most once per
+	// display frame. Requests in between only mark the frame pending, the
+	// params of the last one win.
+	NF_TRACE_SCOPE("updateParams", "handoff");
+	if (!enabled_) return;
+	if (frameTimer_.isActive()) {
+		renderPending_ = true;
+		return;
 	}
+	renderer_->render(*params_);
+	frameTimer_.start();
 }
 
 void FractalWidget::exportImageTo(const QString &dir)
@@ -130,6 +186,14 @@ void FractalWidget::reset()
 	settingsWidget_->updateSettings();
 }
 
+void FractalWidget::randomize()
+{
+	// Scatter roots randomly over the unit disc
+	params_->randomize();
+	updateParams();
+	settingsWidget_->updateSettings();
+}
+
 void FractalWidget::runBenchmark()
 {
 	// Disable editing and set params
@@ -140,17 +204,17 @@ void FractalWidget::runBenchmark()
 
 	// Run benchmark
 	benchmarkTimer_.start();
-	renderer_.render(*params_);
+	renderer_->render(*params_);
 }
 
-void FractalWidget::finishBenchmark(const QImage *image)
+void FractalWidget::finishBenchmark(const QImage &image)
 {
 	// Static output string
 	static const QString out = "Rendered %1 pixels in:\n%2 hr, %3 min, %4 sec and %5 ms";
 
 	// Get time and number of pixels
-	if (image != nullptr) {
-		int pixels = image->width() * image->height();
+	if (!image.isNull()) {
+		int pixels = image.width() * image.height();
 		qint64 elapsed = benchmarkTimer_.elapsed();
 		int s = elapsed / 1000;
 		int ms = elapsed % 1000;
@@ -172,7 +236,7 @@ void FractalWidget::finishBenchmark(const QImage *image)
 			dir = QFileDialog::getExistingDirectory(this, tr("Export fractal to"), dir);
 			if (!dir.isEmpty()) {
 				settings.setValue("imagedir", dir);
-				image->save(dir + "/" + dynamicFileName(*params_, "bmp"), "BMP", 100);
+				image.save(dir + "/" + dynamicFileName(*params_, "bmp"), "BMP", 100);
 			}
 		}
 	}
@@ -194,11 +258,13 @@ void FractalWidget::enable(bool value)
 	}
 }
 
-void FractalWidget::updateFractal(const QPixmap &pixmap, double fps)
+void FractalWidget::updateFractal(const QImage &image, double fps)
 {
 	// Update
-	pixmap_ = pixmap;
+	NF_TRACE_SCOPE("QPixmap::fromImage", "paint");
+	pixmap_ = QPixmap::fromImage(image);
 	fps_ = fps;
+	scale_ = image.isNull() ? 1 : double(image.width()) / params_->size.width();
 	update();
 }
 
@@ -210,6 +276,76 @@ void FractalWidget::updateOrbit(const QVector<QPoint> &orbit, double fps)
 	update();
 }
 
+void FractalWidget::updateOrbitField(const OrbitField &field)
+{
+	// Update
+	orbitField_ = field;
+	if (params_->orbitField) update();
+}
+
+void FractalWidget::updateStats(const FrameStats &stats)
+{
+	// Update
+	stats_ = stats;
+	if (overlay_) update();
+}
+
+void FractalWidget::drawStats(QPainter &painter)
+{
+	// Nothing recorded yet or gpu mode
+	if (stats_.isEmpty() || params_->processor == GPU_OPENGL)
+		return;
+
+	// Heatmap of line durations, blue is fast and red is slow
+	static const int strip = 8;
+	const double slowest = qMax<qint64>(1, stats_.slowestLine());
+	const double lineHeight = double(height()) / stats_.lines.size();
+	for (const LineStats &ls : stats_.lines) {
+		double heat = (ls.end - ls.start) / slowest;
+		QRectF line(0, ls.line * lineHeight, width() - strip, qMax(1.0, lineHeight));
+		painter.fillRect(line, QColor::fromHsvF((1.0 - heat) * 0.66, 1.0, 1.0, 0.45));
+
+		// Strip on the right shows which thread rendered the line
+		QRectF thread(width() - strip, line.top(), strip, line.height());
+		painter.fillRect(thread, nf::predefColors[ls.thread % nf::PCC]);
+	}
+
+	// Frame summary
+	static const QString summary = "%1 ms | %2 Mit | %3% converged | %4 threads";
+	const int pixels = qMax(1, stats_.pixels());
+	QString text = summary
+		.arg(stats_.duration() / 1e6, 0, 'f', 1)
+		.arg(stats_.iterations() / 1e6, 0, 'f', 2)
+		.arg(100.0 * stats_.converged() / pixels, 0, 'f', 1)
+		.arg(stats_.threads().size());
+	if (stats_.counters.isValid()) {
+		text += QString(" | IPC %1 | %2 it/kcycle")
+			.arg(stats_.counters.ipc(), 0, 'f', 2)
+			.arg(1000 * stats_.counters.perCycle(stats_.iterations()), 0, 'f', 1);
+	}
+	QRect textRect(10, height() - 40, width() - 20 - strip, 30);
+	painter.drawRoundedRect(textRect, 6, 6);
+	painter.drawText(textRect, Qt::AlignCenter, text);
+}
+
+void FractalWidget::drawOrbitField(QPainter &painter)
+{
+	// Streamlines in the color of the root they lead to, white if none
+	painter.save();
+	painter.setBrush(Qt::NoBrush);
+	for (int i = 0; i < orbitField_.lines.size(); ++i) {
+		const QVector<QPointF> &line = orbitField_.lines[i];
+		if (line.isEmpty()) continue;
+		int root = orbitField_.roots[i];
+		QColor color = root >= 0 && root < params_->roots.count() ? params_->roots[root].color() : QColor(Qt::white);
+		color.setAlpha(170);
+		painter.setPen(QPen(color, 1));
+		painter.drawPolyline(line.constData(), line.size());
+		painter.drawEllipse(line.first(), 1.5, 1.5);
+	}
+	painter.restore();
+}
+
 void FractalWidget::initializeGL()
 {
 	// Check for support
@@ -240,25 +376,31 @@ void FractalWidget::paintGL()
 	static const QPixmap pixOrbit("://resources/icons/orbit.png");
 	static const QPixmap pixPosition("://resources/icons/position.png");
 	static const QPixmap pixFps("://resources/icons/fps.png");
+	static const QPixmap pixStats = QPixmap("://resources/icons/benchmark.png").scaled(pixFps.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
 
 	// Static legend geometry
 	static const int spacing = 10;
 	static const QFont consolas("Consolas", 12);
 	static const QFontMetrics metrics(consolas);
 #if QT_VERSION >= 0x050B00 // For any Qt Version >= 5.11.0 metrics.width() is deprecated
-	static const int textWidth = 3 * spacing + pixFps.width() + metrics.horizontalAdvance("999.99");
+	static const int textWidth = qMax(3 * spacing + pixFps.width() + metrics.horizontalAdvance("999.99"),
+		2 * spacing + metrics.horizontalAdvance("double rotated4 equalized 99%"));
 #else
-	static const int textWidth = 3 * spacing + pixFps.width() + metrics.width("999.99");
+	static const int textWidth = qMax(3 * spacing + pixFps.width() + metrics.width("999.99"),
+		2 * spacing + metrics.width("double rotated4 equalized 99%"));
 #endif
-	static const int textHeight = spacing + 5 * (pixFps.height() + spacing);
+	static const int textHeight = spacing + 6 * (pixFps.height() + spacing) + metrics.height() + spacing;
 	static const QRect legendRect(spacing, spacing, textWidth, textHeight);
 	static const QPoint ptHide(legendRect.topLeft() + QPoint(spacing, spacing));
 	static const QPoint ptSettings(ptHide + QPoint(0, pixHide.height() + spacing));
 	static const QPoint ptOrbit(ptSettings + QPoint(0, pixSettings.height() + spacing));
 	static const QPoint ptPosition(ptOrbit + QPoint(0, pixOrbit.height() + spacing));
-	static const QPoint ptFps(ptPosition + QPoint(0, pixPosition.height() + spacing));
+	static const QPoint ptStats(ptPosition + QPoint(0, pixPosition.height() + spacing));
+	static const QPoint ptFps(ptStats + QPoint(0, pixStats.height() + spacing));
+	static const QPoint ptPrecision(ptFps + QPoint(0, pixFps.height() + spacing));
 
 	// Paint fractal
+	NF_TRACE_SCOPE("paintGL", "paint");
 	QPainter painter(this);
 	painter.setFont(consolas);
 	painter.setRenderHint(QPainter::Antialiasing);
@@ -268,8 +410,8 @@ void FractalWidget::paintGL()
 	if (params_->processor != GPU_OPENGL && !pixmap_.isNull()) {
 		painter.drawPixmap(rect(), pixmap_);
 	} else {
-		// Update params and draw
-		quint8 rootCount = params_->roots.count();
+		// Update params and draw, the shader holds up to nf::GRC roots
+		const int rootCount = qMin<int>(params_->roots.count(), nf::GRC);
 		program_->bind();
 		program_->enableAttributeArray(0);
 		program_->setAttributeArray(0, vertices.constData());
@@ -277,6 +419,7 @@ void FractalWidget::paintGL()
 		program_->setUniformValue("limits", params_->limits.vec4());
 		program_->setUniformValue("maxIterations", params_->maxIterations);
 		program_->setUniformValue("damping", complex2vec2(params_->damping));
+		program_->setUniformValue("smoothColoring", params_->coloring == COLORING_SMOOTH);
 		program_->setUniformValue("size", QVector2D(size().width(), size().height()));
 		program_->setUniformValueArray("roots", params_->rootsVec2().constData(), rootCount);
 		program_->setUniformValueArray("colors", params_->colorsVec3().constData(), rootCount);
@@ -288,12 +431,22 @@ void FractalWidget::paintGL()
 	painter.setPen(circlePen);
 	painter.setBrush(opaqueBrush);
 
+	// Draw orbit field if enabled
+	if (params_->orbitField && !orbitField_.isEmpty()) {
+		drawOrbitField(painter);
+	}
+
+	// Draw render statistics if enabled
+	if (overlay_) {
+		drawStats(painter);
+	}
+
 	// Draw roots and legend if enabled
 	if (legend_) {
 
 		// Draw roots
-		quint8 rootCount = params_->roots.count();
-		for (quint8 i = 0; i < rootCount; ++i) {
+		const int rootCount = params_->roots.count();
+		for (int i = 0; i < rootCount; ++i) {
 			QPoint point = params_->complex2point(params_->roots[i].value());
 			painter.drawEllipse(point, nf::RIR, nf::RIR);
 		}
@@ -304,12 +457,31 @@ void FractalWidget::paintGL()
 		painter.drawPixmap(ptSettings, pixSettings);
 		painter.drawPixmap(ptOrbit, pixOrbit);
 		painter.drawPixmap(ptPosition, pixPosition);
+		painter.drawPixmap(ptStats, pixStats);
 		painter.drawPixmap(ptFps, pixFps);
 		painter.drawText(ptHide + QPoint(pixHide.width() + spacing, metrics.height() - 4), "ESC");
 		painter.drawText(ptSettings + QPoint(pixSettings.width() + spacing, metrics.height() - 4), "F1");
 		painter.drawText(ptOrbit + QPoint(pixOrbit.width() + spacing, metrics.height() - 4), "F2");
 		painter.drawText(ptPosition + QPoint(pixPosition.width() + spacing, metrics.height() - 4), "F3");
+		painter.drawText(ptStats + QPoint(pixStats.width() + spacing, metrics.height() - 4), "F4");
 		painter.drawText(ptFps + QPoint(pixFps.width() + spacing, metrics.height() - 4), QString::number(fps_, 'f', 2));
+
+		// Kernel precision, sample pattern and scale of the frame, the shader
+		// always uses float at full size
+		Precision precision = params_->processor == GPU_OPENGL ? PRECISION_FLOAT : params_->precision();
+		QString kernel = precision2string(precision);
+		if (params_->processor != GPU_OPENGL && params_->densityMap)
+			kernel += " density";
+		else if (params_->processor != GPU_OPENGL && params_->antiAliasing != SAMPLES_NONE)
+			kernel += " " + samples2string(params_->antiAliasing);
+		const bool colored = params_->processor == GPU_OPENGL ? params_->coloring == COLORING_SMOOTH : !params_->densityMap;
+		if (colored && params_->coloring != COLORING_SHADED)
+			kernel += " " + coloring2string(params_->coloring);
+		if (params_->processor != GPU_OPENGL && !params_->function.isEmpty() && params_->nativeFunction)
+			kernel += " native";
+		if (params_->processor != GPU_OPENGL && qRound(100 * scale_) < 100)
+			kernel += QString(" %1%").arg(qRound(100 * scale_));
+		painter.drawText(ptPrecision + QPoint(0, metrics.height() - 4), kernel);
 	}
 
 	// Draw position if enabled
@@ -340,6 +512,7 @@ void FractalWidget::paintGL()
 void FractalWidget::resizeGL(int w, int h)
 {
 	// Overwrite size with scaleSize for smooth resizing
+	NF_TRACE_SCOPE("resizeGL", "input");
 	if (!scaleDownTimer_.isActive() && params_->processor != GPU_OPENGL)
 		params_->scaleDown = true;
 
@@ -357,6 +530,7 @@ void FractalWidget::resizeGL(int w, int h)
 void FractalWidget::mousePressEvent(QMouseEvent *event)
 {
 	// Return if disabled
+	NF_TRACE_SCOPE("mousePressEvent", "input");
 	if (!enabled_) return;
 
 	// Set scaleDown, previousPos and orbit
@@ -382,6 +556,7 @@ void FractalWidget::mousePressEvent(QMouseEvent *event)
 void FractalWidget::mouseMoveEvent(QMouseEvent *event)
 {
 	// Return if disabled
+	NF_TRACE_SCOPE("mouseMoveEvent", "input");
 	if (!enabled_) return;
 
 	// Move root if dragging
@@ -423,6 +598,7 @@ void FractalWidget::mouseMoveEvent(QMouseEvent *event)
 void FractalWidget::mouseReleaseEvent(QMouseEvent *event)
 {
 	// Return if disabled
+	NF_TRACE_SCOPE("mouseReleaseEvent", "input");
 	if (!enabled_) return;
 
 	// Reset dragging and render actual size
@@ -436,6 +612,7 @@ void FractalWidget::mouseReleaseEvent(QMouseEvent *event)
 void FractalWidget::wheelEvent(QWheelEvent *event)
 {
 	// Return if disabled
+	NF_TRACE_SCOPE("wheelEvent", "input");
 	if (!enabled_) return;
 
 	// Calculate weight
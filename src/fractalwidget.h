@@ -8,6 +8,7 @@
 
 #include "renderer.h"
 #include <QTimer>
+#include <QThread>
 #include <QElapsedTimer>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
@@ -15,6 +16,7 @@
 
 struct Parameters;
 class SettingsWidget;
+class QPainter;
 
 enum DraggingMode : quint8 { NoDragging, DraggingRoot, DraggingFractal };
 
@@ -35,15 +37,20 @@ public:
 	void updateParams();
 	void exportImageTo(const QString &dir);
 	void reset();
+	void randomize();
 
 public slots:
-	void updateFractal(const QPixmap &pixmap, double fps);
+	void updateFractal(const QImage &image, double fps);
 	void updateOrbit(const QVector<QPoint> &orbit, double fps);
+	void updateOrbitField(const OrbitField &field);
+	void updateStats(const FrameStats &stats);
 	void runBenchmark();
-	void finishBenchmark(const QImage *image);
+	void finishBenchmark(const QImage &image);
 
 protected:
 	void enable(bool value);
+	void drawStats(QPainter &painter);
+	void drawOrbitField(QPainter &painter);
 	void initializeGL() override;
 	void paintGL() override;
 	void resizeGL(int w, int h) override;
@@ -56,16 +63,23 @@ private:
 	bool enabled_;
 	QPixmap pixmap_;
 	QTimer scaleDownTimer_;
+	QTimer frameTimer_;
 	QElapsedTimer benchmarkTimer_;
 	QVector<QPoint> orbit_;
+	OrbitField orbitField_;
 	Parameters *params_;
 	SettingsWidget *settingsWidget_;
 	QOpenGLShaderProgram *program_;
-	Renderer renderer_;
+	Renderer *renderer_;
+	QThread renderThread_;
 	Dragger dragger_;
+	FrameStats stats_;
 	double fps_;
+	double scale_;
 	bool legend_;
 	bool position_;
+	bool overlay_;
+	bool renderPending_;
 };
 
 #endif // FRACTALWIDGET_H
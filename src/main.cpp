@@ -4,12 +4,16 @@
 // see the file LICENSE in the main directory.
 
 #include "fractalwidget.h"
+#include "tracer.h"
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
-	// Register metatype
+	// Register metatypes of signals crossing the render thread
 	qRegisterMetaType<QVector<QPoint>>("QVector<QPoint>");
+	qRegisterMetaType<FrameStats>("FrameStats");
+	qRegisterMetaType<OrbitField>("OrbitField");
 
 	// Initialize application
 	QApplication app(argc, argv);
@@ -18,6 +22,19 @@ int main(int argc, char *argv[])
 	app.setApplicationName("NewtonFractal");
 	app.setApplicationVersion(APP_VERSION);
 
+	// Parse command line
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addOption({"trace", "Write a Chrome trace of rendering and input to <file>.", "file"});
+	parser.process(app);
+
+	// Start tracing if requested, NF_TRACE works as well
+	QString trace = parser.isSet("trace") ? parser.value("trace") : QString::fromLocal8Bit(qgetenv("NF_TRACE"));
+	if (!trace.isEmpty()) {
+		Tracer::instance().start(trace);
+	}
+
 	// Set format
 	QSurfaceFormat fmt;
 	fmt.setSamples(10);
@@ -26,5 +43,9 @@ int main(int argc, char *argv[])
 	// Create widget
 	FractalWidget widget;
 	widget.show();
-	return app.exec();
+	int result = app.exec();
+
+	// Write trace
+	Tracer::instance().stop();
+	return result;
 }
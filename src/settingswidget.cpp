@@ -6,6 +6,7 @@
 #include "settingswidget.h"
 #include "ui_settingswidget.h"
 #include "parameters.h"
+#include "expression.h"
 #include "rootedit.h"
 #include "rooticon.h"
 #include <QDesktopServices>
@@ -17,6 +18,7 @@
 #include <QMenu>
 #include <QUrl>
 #include <QDebug>
+#include <algorithm>
 
 static bool updateParamsAllowed = true;
 
@@ -58,6 +60,7 @@ SettingsWidget::SettingsWidget(Parameters *params, QWidget *parent) :
 	connect(ui_->lineDamping, &RootEdit::valueChanged, this, &SettingsWidget::on_settingsChanged);
 	connect(ui_->spinZoom, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &SettingsWidget::on_settingsChanged);
 	connect(ui_->cbThreading, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SettingsWidget::on_settingsChanged);
+	connect(ui_->lineFunction, &QLineEdit::editingFinished, this, &SettingsWidget::on_settingsChanged);
 	connect(ui_->cbStyles, QOverload<const QString &>::of(&QComboBox::currentIndexChanged), [this](const QString &style) {
 		QSettings().setValue("style", style);
 		styler_.setStyle(style);
@@ -92,7 +95,7 @@ void SettingsWidget::updateSettings()
 	updateParamsAllowed = false;
 
 	// Update settings from params
-	quint8 rootCount = params_->roots.count();
+	const int rootCount = params_->roots.count();
 	ui_->lineSize->setValue(params_->size);
 	ui_->spinScaleDownFactor->setValue(params_->scaleDownFactor * 100);
 	ui_->spinZoom->setValue(params_->limits.zoomFactor() * 100);
@@ -100,7 +103,8 @@ void SettingsWidget::updateSettings()
 	ui_->spinDegree->setValue(rootCount);
 	ui_->lineDamping->setValue(params_->damping);
 	ui_->cbThreading->setCurrentIndex(static_cast<quint8>(params_->processor));
-	for (quint8 i = 0; i < rootCount; ++i) {
+	ui_->lineFunction->setText(params_->function);
+	for (int i = 0; i < rootCount; ++i) {
 		moveRoot(i, params_->roots[i].value());
 	}
 	updateParamsAllowed = true;
@@ -139,7 +143,7 @@ void SettingsWidget::addRoot(complex value, QColor color)
 	// Create new root and apend it to parameters
 	int rootCount = params_->roots.count();
 	if (rootCount < nf::MRC) {
-		Root root(value, color == Qt::black ? nf::predefColors[rootCount] : color);
+		Root root(value, color == Qt::black ? nf::predefColors[rootCount % nf::PCC] : color);
 		params_->roots.append(root);
 
 		// Create RootEdit, add it to list and layout and connect its signal
@@ -160,10 +164,10 @@ void SettingsWidget::addRoot(complex value, QColor color)
 	}
 }
 
-void SettingsWidget::removeRoot(qint8 index)
+void SettingsWidget::removeRoot(int index)
 {
 	// Remove rootedit and icon
-	quint8 rootCount = params_->roots.count();
+	const int rootCount = params_->roots.count();
 	index = index < 0 ? rootCount - 1 : index;
 	RootEdit *edit = rootEdits_.takeAt(index);
 	RootIcon *icon = rootIcons_.takeAt(index);
@@ -174,7 +178,7 @@ void SettingsWidget::removeRoot(qint8 index)
 	delete icon;
 
 	// Shift others up
-	for (quint8 i = index; i < rootCount - 1; ++i) {
+	for (int i = index; i < rootCount - 1; ++i) {
 		ui_->gridRoots->removeWidget(rootEdits_[i]);
 		ui_->gridRoots->removeWidget(rootIcons_[i]);
 		ui_->gridRoots->addWidget(rootEdits_[i], i + 1, 1);
@@ -185,7 +189,7 @@ void SettingsWidget::removeRoot(qint8 index)
 	ui_->spinDegree->setValue(params_->roots.count());
 }
 
-void SettingsWidget::moveRoot(quint8 index, complex value)
+void SettingsWidget::moveRoot(int index, complex value)
 {
 	// Update settings
 	if (index < rootEdits_.size()) {
@@ -254,9 +258,17 @@ void SettingsWidget::exportSettings()
 	ini.setValue("damping", complex2string(params_->damping));
 	ini.setValue("scaleDownFactor", params_->scaleDownFactor);
 	ini.setValue("scaleDown", params_->scaleDown);
+	ini.setValue("frameBudget", params_->frameBudget);
+	ini.setValue("capIterations", params_->capIterations);
 	ini.setValue("processor", static_cast<uint>(params_->processor));
 	ini.setValue("orbitMode", params_->orbitMode);
 	ini.setValue("orbitStart", params_->orbitStart);
+	ini.setValue("orbitField", params_->orbitField);
+	ini.setValue("densityMap", params_->densityMap);
+	ini.setValue("coloring", static_cast<uint>(params_->coloring));
+	ini.setValue("function", params_->function);
+	ini.setValue("nativeFunction", params_->nativeFunction);
+	ini.setValue("antiAliasing", static_cast<uint>(params_->antiAliasing));
 	ini.endGroup();
 
 	// Limits
@@ -265,16 +277,20 @@ void SettingsWidget::exportSettings()
 	ini.setValue("right", params_->limits.right());
 	ini.setValue("top", params_->limits.top());
 	ini.setValue("bottom", params_->limits.bottom());
-	ini.setValue("left_original", params_->limits.original()->left());
-	ini.setValue("right_original", params_->limits.original()->right());
-	ini.setValue("top_original", params_->limits.original()->top());
-	ini.setValue("bottom_original", params_->limits.original()->bottom());
+	ini.setValue("left_original", params_->limits.original().left());
+	ini.setValue("right_original", params_->limits.original().right());
+	ini.setValue("top_original", params_->limits.original().top());
+	ini.setValue("bottom_original", params_->limits.original().bottom());
+	ini.setValue("left_low", params_->limits.leftDD().lo);
+	ini.setValue("right_low", params_->limits.rightDD().lo);
+	ini.setValue("top_low", params_->limits.topDD().lo);
+	ini.setValue("bottom_low", params_->limits.bottomDD().lo);
 	ini.endGroup();
 
 	// Roots
 	ini.beginGroup("Roots");
-	quint8 rootCount = params_->roots.count();
-	for (quint8 i = 0; i < rootCount; ++i) {
+	const int rootCount = params_->roots.count();
+	for (int i = 0; i < rootCount; ++i) {
 		ini.setValue(
 			"root" + QString::number(i),
 			complex2string(params_->roots[i].value(), 10) + " : " + params_->roots[i].color().name()
@@ -305,16 +321,27 @@ void SettingsWidget::importSettings()
 	params_->damping = string2complex(ini.value("damping", complex2string(nf::DDP)).toString());
 	params_->scaleDownFactor = ini.value("scaleDownFactor", nf::DSC).toDouble();
 	params_->scaleDown = ini.value("scaleDown", false).toBool();
+	params_->frameBudget = qMax(0.0, ini.value("frameBudget", nf::DFB).toDouble());
+	params_->capIterations = ini.value("capIterations", false).toBool();
 	params_->processor = static_cast<Processor>(ini.value("processor", 1).toUInt());
 	params_->orbitMode = ini.value("orbitMode", false).toBool();
 	params_->orbitStart = ini.value("orbitStart").toPoint();
+	params_->orbitField = ini.value("orbitField", false).toBool();
+	params_->densityMap = ini.value("densityMap", false).toBool();
+	params_->coloring = static_cast<Coloring>(qMin<uint>(ini.value("coloring", 0).toUInt(), COLORING_SMOOTH));
+	params_->function = Expression::compile(ini.value("function").toString()).text();
+	if (!params_->function.isEmpty() && params_->processor == GPU_OPENGL) params_->processor = CPU_MULTI;
+	params_->nativeFunction = ini.value("nativeFunction", false).toBool();
+	params_->antiAliasing = static_cast<SamplePattern>(qMin<uint>(ini.value("antiAliasing", 0).toUInt(), SAMPLES_GRID16));
 	ini.endGroup();
 
 	// Limits
 	ini.beginGroup("Limits");
 	params_->limits.set(
-		ini.value("left", 1).toDouble(), ini.value("right", 1).toDouble(),
-		ini.value("top", 1).toDouble(), ini.value("bottom", 1).toDouble());
+		ddouble(ini.value("left", 1).toDouble(), ini.value("left_low", 0).toDouble()),
+		ddouble(ini.value("right", 1).toDouble(), ini.value("right_low", 0).toDouble()),
+		ddouble(ini.value("top", 1).toDouble(), ini.value("top_low", 0).toDouble()),
+		ddouble(ini.value("bottom", 1).toDouble(), ini.value("bottom_low", 0).toDouble()));
 	params_->limits.setOriginal(
 		ini.value("left_original", 1).toDouble(), ini.value("right_original", 1).toDouble(),
 		ini.value("top_original", 1).toDouble(), ini.value("bottom_original", 1).toDouble());
@@ -325,14 +352,18 @@ void SettingsWidget::importSettings()
 	updateSettings();
 
 	// Remove old roots
-	quint8 rootCount = params_->roots.count();
-	for (quint8 i = 0; i < rootCount; ++i) {
+	const int rootCount = params_->roots.count();
+	for (int i = 0; i < rootCount; ++i) {
 		removeRoot();
 	}
 
-	// Add Roots
+	// Add Roots in the order of their number, root10 sorts before root2
 	ini.beginGroup("Roots");
-	for (QString key : ini.childKeys()) {
+	QStringList keys = ini.childKeys();
+	std::stable_sort(keys.begin(), keys.end(), [](const QString &a, const QString &b) {
+		return a.mid(4).toInt() < b.mid(4).toInt();
+	});
+	for (QString key : keys) {
 		QStringList str = ini.value(key).toString().split(":");
 		if (str.length() >= 2) {
 			addRoot(string2complex(str.first()), QColor(str.last().simplified()));
@@ -340,6 +371,12 @@ void SettingsWidget::importSettings()
 	}
 	ini.endGroup();
 
+	// The OpenGL renderer holds up to nf::GRC roots
+	if (params_->roots.count() > nf::GRC && params_->processor == GPU_OPENGL) {
+		params_->processor = CPU_MULTI;
+		updateSettings();
+	}
+
 }
 
 void SettingsWidget::openRootContextMenu()
@@ -347,7 +384,7 @@ void SettingsWidget::openRootContextMenu()
 	// Open root context menu
 	RootIcon *icon = dynamic_cast<RootIcon*>(sender()); // meh
 	if (icon != nullptr) {
-		quint8 index = rootIcons_.indexOf(icon);
+		int index = rootIcons_.indexOf(icon);
 		QList<QAction*> actions = rootMenu_->actions();
 		QAction *clicked = rootMenu_->exec(icon->mapToGlobal(QPoint(0, 0)), actions[0]);
 
@@ -399,9 +436,23 @@ void SettingsWidget::on_settingsChanged()
 		params_->processor = static_cast<Processor>(ui_->cbThreading->currentIndex());
 		params_->scaleUpFactor = ui_->spinScaleUpFactor->value();
 
+		// Keep the last function that compiled, custom functions and more
+		// than nf::GRC roots need the cpu
+		QString error;
+		Expression expression = Expression::compile(ui_->lineFunction->text(), &error);
+		ui_->lineFunction->setToolTip(error);
+		if (error.isEmpty()) params_->function = expression.text();
+		const bool cpu = !params_->function.isEmpty() || params_->roots.count() > nf::GRC;
+		if (cpu && params_->processor == GPU_OPENGL) {
+			updateParamsAllowed = false;
+			ui_->cbThreading->setCurrentIndex(static_cast<quint8>(CPU_MULTI));
+			updateParamsAllowed = true;
+			params_->processor = CPU_MULTI;
+		}
+
 		// Update rootEdit value
 		if (rootEdits_.size() == params_->roots.count()) {
-			for (quint8 i = 0; i < rootEdits_.size(); ++i) {
+			for (int i = 0; i < rootEdits_.size(); ++i) {
 				params_->roots[i].setValue(rootEdits_[i]->value());
 			}
 		}
@@ -35,8 +35,8 @@ public slots:
 	void changeSize(QSize size);
 	void changeZoom(double factor);
 	void addRoot(complex value = complex(0, 0), QColor color = Qt::black);
-	void removeRoot(qint8 index = -1);
-	void moveRoot(quint8 index, complex value);
+	void removeRoot(int index = -1);
+	void moveRoot(int index, complex value);
 	void setBenchmarkProgress(int min, int max, int progress);
 	void toggleBenchmarking(bool value);
 	void exportImage();
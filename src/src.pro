@@ -0,0 +1,46 @@
+include(../common.pri)
+include(../core/core.pri)
+
+QT += widgets
+
+TARGET = NewtonFractal
+TEMPLATE = app
+win32:LIBS += -lOpenGL32
+unix:LIBS += -lOpenGL
+
+# The form references its custom widgets as src/*.h
+INCLUDEPATH += $$PWD/..
+
+RC_ICONS = ../resources/icons/icon.ico
+DESTDIR = ../build
+
+SOURCES += \
+    main.cpp \
+    fractalwidget.cpp \
+    rootedit.cpp \
+    sizeedit.cpp \
+    settingswidget.cpp \
+    rooticon.cpp \
+    styler.cpp
+
+HEADERS += \
+    fractalwidget.h \
+    rootedit.h \
+    sizeedit.h \
+    settingswidget.h \
+    rooticon.h \
+    styler.h
+
+FORMS += \
+    settingswidget.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+RESOURCES += \
+    ../resources.qrc
+
+DISTFILES += \
+    fractal.fsh